@@ -358,7 +358,9 @@ int cmCTestBuildHandler::ProcessHandler()
     this->CustomWarningExceptions.emplace_back(cmCTestWarningExceptions[cc]);
   }
 
-  // Pre-compile regular expressions objects for all regular expressions
+  // Pre-compile regular expressions objects for all regular expressions.
+  // They are matched against every line of the build output, so use the
+  // automaton that takes linear time on any expression.
 
 #define cmCTestBuildHandlerPopulateRegexVector(strings, regexes)              \
   do {                                                                        \
@@ -370,6 +372,12 @@ int cmCTestBuildHandler::ProcessHandler()
                          "Add " #strings ": " << s << std::endl,              \
                          this->Quiet);                                        \
       (regexes).emplace_back(s);                                              \
+      if (!(regexes).back().IsValid()) {                                      \
+        cmCTestLog(this->CTest, WARNING,                                      \
+                   "Invalid build output regular expression \""               \
+                     << s << "\": " << (regexes).back().GetError()            \
+                     << std::endl);                                           \
+      }                                                                       \
     }                                                                         \
   } while (false)
 
@@ -1105,8 +1113,8 @@ int cmCTestBuildHandler::ProcessSingleLine(const char* data)
   if (!this->ErrorQuotaReached) {
     // Errors
     int wrxCnt = 0;
-    for (cmsys::RegularExpression& rx : this->ErrorMatchRegex) {
-      if (rx.find(line.c_str())) {
+    for (cmRegularExpressionAutomaton& rx : this->ErrorMatchRegex) {
+      if (rx.Find(line)) {
         errorLine = 1;
         cmCTestOptionalLog(this->CTest, DEBUG,
                            "  Error Line: " << line << " (matches: "
@@ -1119,8 +1127,8 @@ int cmCTestBuildHandler::ProcessSingleLine(const char* data)
     }
     // Error exceptions
     wrxCnt = 0;
-    for (cmsys::RegularExpression& rx : this->ErrorExceptionRegex) {
-      if (rx.find(line.c_str())) {
+    for (cmRegularExpressionAutomaton& rx : this->ErrorExceptionRegex) {
+      if (rx.Find(line)) {
         errorLine = 0;
         cmCTestOptionalLog(this->CTest, DEBUG,
                            "  Not an error Line: "
@@ -1136,8 +1144,8 @@ int cmCTestBuildHandler::ProcessSingleLine(const char* data)
   if (!this->WarningQuotaReached) {
     // Warnings
     int wrxCnt = 0;
-    for (cmsys::RegularExpression& rx : this->WarningMatchRegex) {
-      if (rx.find(line.c_str())) {
+    for (cmRegularExpressionAutomaton& rx : this->WarningMatchRegex) {
+      if (rx.Find(line)) {
         warningLine = 1;
         cmCTestOptionalLog(this->CTest, DEBUG,
                            "  Warning Line: "
@@ -1152,8 +1160,8 @@ int cmCTestBuildHandler::ProcessSingleLine(const char* data)
 
     wrxCnt = 0;
     // Warning exceptions
-    for (cmsys::RegularExpression& rx : this->WarningExceptionRegex) {
-      if (rx.find(line.c_str())) {
+    for (cmRegularExpressionAutomaton& rx : this->WarningExceptionRegex) {
+      if (rx.Find(line)) {
         warningLine = 0;
         cmCTestOptionalLog(this->CTest, DEBUG,
                            "  Not a warning Line: "
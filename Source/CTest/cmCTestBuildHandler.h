@@ -17,6 +17,7 @@
 #include "cmCTestGenericHandler.h"
 #include "cmDuration.h"
 #include "cmProcessOutput.h"
+#include "cmRegularExpressionAutomaton.h"
 
 class cmMakefile;
 class cmStringReplaceHelper;
@@ -107,10 +108,10 @@ private:
   std::vector<std::string> ReallyCustomWarningExceptions;
   std::vector<cmCTestCompileErrorWarningRex> ErrorWarningFileLineRegex;
 
-  std::vector<cmsys::RegularExpression> ErrorMatchRegex;
-  std::vector<cmsys::RegularExpression> ErrorExceptionRegex;
-  std::vector<cmsys::RegularExpression> WarningMatchRegex;
-  std::vector<cmsys::RegularExpression> WarningExceptionRegex;
+  std::vector<cmRegularExpressionAutomaton> ErrorMatchRegex;
+  std::vector<cmRegularExpressionAutomaton> ErrorExceptionRegex;
+  std::vector<cmRegularExpressionAutomaton> WarningMatchRegex;
+  std::vector<cmRegularExpressionAutomaton> WarningExceptionRegex;
 
   using t_BuildProcessingQueueType = std::deque<char>;
 
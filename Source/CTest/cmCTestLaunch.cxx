@@ -7,12 +7,12 @@
 
 #include "cmsys/FStream.hxx"
 #include "cmsys/Process.h"
-#include "cmsys/RegularExpression.hxx"
 
 #include "cmCTestLaunchReporter.h"
 #include "cmGlobalGenerator.h"
 #include "cmMakefile.h"
 #include "cmProcessOutput.h"
+#include "cmRegularExpressionAutomaton.h"
 #include "cmState.h"
 #include "cmStateSnapshot.h"
 #include "cmStringAlgorithms.h"
@@ -265,16 +265,20 @@ void cmCTestLaunch::LoadScrapeRules()
 }
 
 void cmCTestLaunch::LoadScrapeRules(
-  const char* purpose, std::vector<cmsys::RegularExpression>& regexps) const
+  const char* purpose,
+  std::vector<cmRegularExpressionAutomaton>& regexps) const
 {
   std::string fname =
     cmStrCat(this->Reporter.LogDir, "Custom", purpose, ".txt");
   cmsys::ifstream fin(fname.c_str(), std::ios::in | std::ios::binary);
   std::string line;
-  cmsys::RegularExpression rex;
+  cmRegularExpressionAutomaton rex;
   while (cmSystemTools::GetLineFromStream(fin, line)) {
-    if (rex.compile(line)) {
+    if (rex.Compile(line)) {
       regexps.push_back(rex);
+    } else {
+      std::cerr << "Invalid " << purpose << " regular expression \"" << line
+                << "\" in " << fname << ": " << rex.GetError() << "\n";
     }
   }
 }
@@ -9,9 +9,7 @@
 
 #include "cmCTestLaunchReporter.h"
 
-namespace cmsys {
-class RegularExpression;
-}
+class cmRegularExpressionAutomaton;
 
 /** \class cmCTestLaunch
  * \brief Launcher for make rules to report results for ctest
@@ -60,7 +58,7 @@ private:
   bool ScrapeRulesLoaded;
   void LoadScrapeRules();
   void LoadScrapeRules(const char* purpose,
-                       std::vector<cmsys::RegularExpression>& regexps) const;
+                       std::vector<cmRegularExpressionAutomaton>& regexps) const;
   bool ScrapeLog(std::string const& fname);
 
   // Helper class to generate the xml fragment.
@@ -4,7 +4,6 @@
 
 #include "cmsys/FStream.hxx"
 #include "cmsys/Process.h"
-#include "cmsys/RegularExpression.hxx"
 
 #include "cmCryptoHash.h"
 #include "cmGeneratedFileStream.h"
@@ -299,10 +298,10 @@ void cmCTestLaunchReporter::DumpFileToXML(cmXMLElement& e3, const char* tag,
 }
 
 bool cmCTestLaunchReporter::Match(
-  std::string const& line, std::vector<cmsys::RegularExpression>& regexps)
+  std::string const& line, std::vector<cmRegularExpressionAutomaton>& regexps)
 {
-  for (cmsys::RegularExpression& r : regexps) {
-    if (r.find(line)) {
+  for (cmRegularExpressionAutomaton& r : regexps) {
+    if (r.Find(line)) {
       return true;
     }
   }
@@ -8,7 +8,7 @@
 #include <string>
 #include <vector>
 
-#include "cmsys/RegularExpression.hxx"
+#include "cmRegularExpressionAutomaton.h"
 
 class cmXMLElement;
 
@@ -61,11 +61,12 @@ public:
   void LoadLabels();
   bool SourceMatches(std::string const& lhs, std::string const& rhs);
 
-  // Regular expressions to match warnings and their exceptions.
-  std::vector<cmsys::RegularExpression> RegexWarning;
-  std::vector<cmsys::RegularExpression> RegexWarningSuppress;
+  // Regular expressions to match warnings and their exceptions.  They
+  // scan all compiler output, so they are matched in linear time.
+  std::vector<cmRegularExpressionAutomaton> RegexWarning;
+  std::vector<cmRegularExpressionAutomaton> RegexWarningSuppress;
   bool Match(std::string const& line,
-             std::vector<cmsys::RegularExpression>& regexps);
+             std::vector<cmRegularExpressionAutomaton>& regexps);
   bool MatchesFilterPrefix(std::string const& line) const;
 
   // Methods to generate the xml fragment.
@@ -668,8 +668,8 @@ bool cmConditionEvaluator::HandleLevel2(cmArgumentList& newArgs,
       this->Makefile.ClearMatches();
 
       const auto& rex = args.nextnext->GetValue();
-      cmsys::RegularExpression regEntry;
-      if (!regEntry.compile(rex)) {
+      auto regEntry = this->Makefile.GetRegularExpression(rex);
+      if (!regEntry) {
         std::ostringstream error;
         error << "Regular expression \"" << rex << "\" cannot compile";
         errorString = error.str();
@@ -677,9 +677,10 @@ bool cmConditionEvaluator::HandleLevel2(cmArgumentList& newArgs,
         return false;
       }
 
-      const auto match = regEntry.find(*def);
+      cmsys::RegularExpressionMatch regMatch;
+      const auto match = regEntry->find(def->c_str(), regMatch);
       if (match) {
-        this->Makefile.StoreMatches(regEntry);
+        this->Makefile.StoreMatches(regMatch);
       }
       newArgs.ReduceTwoArgs(match, args);
     }
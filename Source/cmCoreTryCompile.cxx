@@ -4,15 +4,20 @@
 
 #include <cstdio>
 #include <cstring>
+#include <iterator>
 #include <set>
 #include <sstream>
+#include <string>
 #include <utility>
 
+#include <cm/optional>
 #include <cm/string_view>
 #include <cmext/string_view>
 
 #include "cmsys/Directory.hxx"
+#include "cmsys/FStream.hxx"
 
+#include "cmCryptoHash.h"
 #include "cmExportTryCompileFileGenerator.h"
 #include "cmGlobalGenerator.h"
 #include "cmMakefile.h"
@@ -23,6 +28,7 @@
 #include "cmStringAlgorithms.h"
 #include "cmSystemTools.h"
 #include "cmTarget.h"
+#include "cmTryCompileCache.h"
 #include "cmValue.h"
 #include "cmVersion.h"
 #include "cmake.h"
@@ -235,6 +241,133 @@ std::set<std::string> const ghs_platform_vars{
   "GHS_OS_ROOT",         "GHS_OS_DIR",         "GHS_BSP_NAME",
   "GHS_OS_DIR_OPTION"
 };
+
+/* Variables naming the tools that build the test project.  */
+char const* const try_compile_cache_tool_vars[] = { "CMAKE_LINKER",
+                                                    "CMAKE_AR",
+                                                    "CMAKE_RANLIB",
+                                                    "CMAKE_MT" };
+
+/* Environment variables read by compilers and linkers.  */
+char const* const try_compile_cache_env_vars[] = {
+  "INCLUDE",            "LIB",
+  "CPATH",              "C_INCLUDE_PATH",
+  "CPLUS_INCLUDE_PATH", "LIBRARY_PATH"
+};
+
+/* Name of the file built by a test project, relative to its directory.  */
+std::string TryCompileOutputName(cmMakefile const* mf,
+                                 std::string const& targetName,
+                                 cmStateEnums::TargetType targetType)
+{
+  if (targetType == cmStateEnums::EXECUTABLE) {
+    return cmStrCat('/', targetName,
+                    mf->GetSafeDefinition("CMAKE_EXECUTABLE_SUFFIX"));
+  }
+  // if (targetType == cmStateEnums::STATIC_LIBRARY)
+  return cmStrCat('/', mf->GetSafeDefinition("CMAKE_STATIC_LIBRARY_PREFIX"),
+                  targetName,
+                  mf->GetSafeDefinition("CMAKE_STATIC_LIBRARY_SUFFIX"));
+}
+
+/* Hash a test project file with the names of this particular test project
+   replaced, so that the same test in another build tree has the same
+   key.  */
+void AppendTryCompileCacheFile(cmCryptoHash& hash, std::string const& file,
+                               std::string const& binDir,
+                               std::string const& targetName)
+{
+  cmsys::ifstream fin(file.c_str(), std::ios::in | std::ios::binary);
+  if (!fin) {
+    return;
+  }
+  std::string content{ std::istreambuf_iterator<char>(fin),
+                       std::istreambuf_iterator<char>() };
+  cmSystemTools::ReplaceString(content, binDir, "<BINARY_DIR>");
+  cmSystemTools::ReplaceString(content, targetName, "<TARGET_NAME>");
+  hash.Append(cmStrCat(file.substr(binDir.size()), '\0', content, '\0'));
+}
+
+/* Compute the try_compile cache key of a source file signature test
+   project from everything it is built from: the generated project files,
+   the sources, the variables forwarded to it, and the identity of the
+   toolchain and of CMake.  */
+std::string TryCompileCacheKey(cmMakefile const* mf, std::string const& binDir,
+                               std::string const& targetName,
+                               cmStateEnums::TargetType targetType,
+                               std::set<std::string> const& langs,
+                               std::vector<std::string> const& sources,
+                               std::vector<std::string> const& cmakeFlags)
+{
+  cmCryptoHash hash(cmCryptoHash::AlgoSHA256);
+  hash.Initialize();
+  auto append = [&hash](cm::string_view name, cm::string_view value) {
+    hash.Append(cmStrCat(name, '=', value, '\0'));
+  };
+
+  append("CMAKE_VERSION"_s, cmVersion::GetCMakeVersion());
+  append("TARGET_TYPE"_s, cmState::GetTargetTypeName(targetType));
+
+  AppendTryCompileCacheFile(hash, cmStrCat(binDir, "/CMakeLists.txt"), binDir,
+                            targetName);
+  AppendTryCompileCacheFile(
+    hash, cmStrCat(binDir, '/', targetName, "Targets.cmake"), binDir,
+    targetName);
+  for (std::string flag : cmakeFlags) {
+    cmSystemTools::ReplaceString(flag, binDir, "<BINARY_DIR>");
+    append("CMAKE_FLAGS"_s, flag);
+  }
+  for (std::string const& si : sources) {
+    std::string name = si;
+    cmSystemTools::ReplaceString(name, binDir, "<BINARY_DIR>");
+    append(name, cmCryptoHash(cmCryptoHash::AlgoSHA256).HashFile(si));
+  }
+
+  // The compiler is identified by its path, id and version, and by the
+  // size and time of its file to notice it being replaced in place.
+  for (std::string const& li : langs) {
+    std::string const compilerVar = cmStrCat("CMAKE_", li, "_COMPILER");
+    std::string const& compiler = mf->GetSafeDefinition(compilerVar);
+    append(compilerVar, compiler);
+    for (cm::string_view suffix :
+         { "_ID"_s, "_VERSION"_s, "_TARGET"_s, "_ARG1"_s }) {
+      std::string const var = cmStrCat(compilerVar, suffix);
+      append(var, mf->GetSafeDefinition(var));
+    }
+    if (!compiler.empty()) {
+      append("SIZE"_s, std::to_string(cmSystemTools::FileLength(compiler)));
+      append("TIME"_s, std::to_string(cmSystemTools::ModifiedTime(compiler)));
+    }
+  }
+  for (char const* var : try_compile_cache_tool_vars) {
+    append(var, mf->GetSafeDefinition(var));
+  }
+
+  cmGlobalGenerator const* gg = mf->GetGlobalGenerator();
+  append("CMAKE_GENERATOR"_s, gg->GetName());
+  append("CMAKE_GENERATOR_PLATFORM"_s,
+         mf->GetSafeDefinition("CMAKE_GENERATOR_PLATFORM"));
+  append("CMAKE_GENERATOR_TOOLSET"_s,
+         mf->GetSafeDefinition("CMAKE_GENERATOR_TOOLSET"));
+  append("CMAKE_TRY_COMPILE_CONFIGURATION"_s,
+         mf->GetSafeDefinition("CMAKE_TRY_COMPILE_CONFIGURATION"));
+
+  std::string const& toolchain = mf->GetSafeDefinition("CMAKE_TOOLCHAIN_FILE");
+  append("CMAKE_TOOLCHAIN_FILE"_s, toolchain);
+  if (!toolchain.empty()) {
+    append("CMAKE_TOOLCHAIN_FILE_HASH"_s,
+           cmCryptoHash(cmCryptoHash::AlgoSHA256).HashFile(toolchain));
+  }
+
+  for (char const* var : try_compile_cache_env_vars) {
+    std::string value;
+    if (cmSystemTools::GetEnv(var, value)) {
+      append(cmStrCat("ENV{", var, '}'), value);
+    }
+  }
+
+  return hash.FinalizeHex();
+}
 }
 
 int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv,
@@ -291,6 +424,7 @@ int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv,
   bool didCopyFileError = false;
   bool useSources = argv[2] == "SOURCES";
   std::vector<std::string> sources;
+  std::set<std::string> testLangs;
 
   enum Doing
   {
@@ -493,7 +627,6 @@ int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv,
 
     // Detect languages to enable.
     cmGlobalGenerator* gg = this->Makefile->GetGlobalGenerator();
-    std::set<std::string> testLangs;
     for (std::string const& si : sources) {
       std::string ext = cmSystemTools::GetFilenameLastExtension(si);
       std::string lang = gg->GetLanguageFromExtension(ext.c_str());
@@ -962,14 +1095,86 @@ int cmCoreTryCompile::TryCompileCode(std::vector<std::string> const& argv,
     }
   }
 
+  // Look for the result of the same test project in the try_compile
+  // cache.  The internal checks made while enabling a language are not
+  // cached: they identify the toolchain that the cache key depends on.
+  std::string cacheDir;
+  if (this->SrcFileSignature && cmakeInternal.empty() &&
+      !this->Makefile->GetCMakeInstance()->GetDebugTryCompile()) {
+    if (cmValue dir =
+          this->Makefile->GetDefinition("CMAKE_TRY_COMPILE_CACHE_DIR")) {
+      cacheDir = *dir;
+    } else {
+      cmSystemTools::GetEnv("CMAKE_TRY_COMPILE_CACHE_DIR", cacheDir);
+    }
+  }
+  std::string cacheKey;
+  cm::optional<cmTryCompileCache::Entry> cached;
+  bool verifyCached = false;
+  if (!cacheDir.empty()) {
+    cacheDir = cmSystemTools::CollapseFullPath(
+      cacheDir, this->Makefile->GetHomeOutputDirectory());
+    cacheKey = TryCompileCacheKey(this->Makefile, this->BinaryDirectory,
+                                  targetName, targetType, testLangs, sources,
+                                  cmakeFlags);
+    cached = cmTryCompileCache(cacheDir).Load(cacheKey);
+    // Only successes are stored: a failure may come from something the key
+    // does not cover, like a missing header, and would stick to every build
+    // tree sharing the cache.  Ignore failures stored by older versions.
+    if (cached && cached->Result != 0) {
+      cached = cm::nullopt;
+    }
+    unsigned long verifyPercent = 0;
+    if (cached &&
+        cmStrToULong(this->Makefile->GetSafeDefinition(
+                       "CMAKE_TRY_COMPILE_CACHE_VERIFY"),
+                     &verifyPercent)) {
+      verifyCached = cmSystemTools::RandomSeed() % 100 < verifyPercent;
+    }
+  }
+
   bool erroroc = cmSystemTools::GetErrorOccuredFlag();
   cmSystemTools::ResetErrorOccuredFlag();
   std::string output;
-  // actually do the try compile now that everything is setup
-  int res = this->Makefile->TryCompile(
-    sourceDirectory, this->BinaryDirectory, projectName, targetName,
-    this->SrcFileSignature, cmake::NO_BUILD_PARALLEL_LEVEL, &cmakeFlags,
-    output);
+  int res;
+  // Use a cached result unless it is sampled for verification, and put the
+  // file built with it where the test project would have built it.
+  bool const useCached = cached && !verifyCached &&
+    (cached->OutputFile.empty() ||
+     cmSystemTools::CopyFileAlways(
+       cached->OutputFile,
+       cmStrCat(this->BinaryDirectory,
+                TryCompileOutputName(this->Makefile, targetName,
+                                     targetType))));
+  if (useCached) {
+    res = cached->Result;
+    output = cmStrCat("Restored from the try_compile cache in\n  ", cacheDir,
+                      "\nentry ", cacheKey, "\n\n", cached->Output);
+  } else {
+    // actually do the try compile now that everything is setup
+    res = this->Makefile->TryCompile(
+      sourceDirectory, this->BinaryDirectory, projectName, targetName,
+      this->SrcFileSignature, cmake::NO_BUILD_PARALLEL_LEVEL, &cmakeFlags,
+      output);
+
+    // Store a success unless the test project itself failed to generate.
+    // Drop a cached success that does not build anymore.
+    if (!cacheKey.empty() && !cmSystemTools::GetErrorOccuredFlag()) {
+      if (cached && res != 0) {
+        this->Makefile->IssueMessage(
+          MessageType::WARNING,
+          cmStrCat("The try_compile cache in\n  ", cacheDir, "\nhas entry ",
+                   cacheKey,
+                   " with a successful result but building its test project "
+                   "again failed.  The entry has been removed."));
+        cmTryCompileCache(cacheDir).Remove(cacheKey);
+      } else if (!cached && res == 0) {
+        this->FindOutputFile(targetName, targetType);
+        cmTryCompileCache(cacheDir).Store(cacheKey, res, output,
+                                          this->OutputFile);
+      }
+    }
+  }
   if (erroroc) {
     cmSystemTools::SetErrorOccured();
   }
@@ -1078,19 +1283,8 @@ void cmCoreTryCompile::FindOutputFile(const std::string& targetName,
 {
   this->FindErrorMessage.clear();
   this->OutputFile.clear();
-  std::string tmpOutputFile = "/";
-  if (targetType == cmStateEnums::EXECUTABLE) {
-    tmpOutputFile += targetName;
-    tmpOutputFile +=
-      this->Makefile->GetSafeDefinition("CMAKE_EXECUTABLE_SUFFIX");
-  } else // if (targetType == cmStateEnums::STATIC_LIBRARY)
-  {
-    tmpOutputFile +=
-      this->Makefile->GetSafeDefinition("CMAKE_STATIC_LIBRARY_PREFIX");
-    tmpOutputFile += targetName;
-    tmpOutputFile +=
-      this->Makefile->GetSafeDefinition("CMAKE_STATIC_LIBRARY_SUFFIX");
-  }
+  std::string const tmpOutputFile =
+    TryCompileOutputName(this->Makefile, targetName, targetType);
 
   // a list of directories where to search for the compilation result
   // at first directly in the binary dir
@@ -237,6 +237,9 @@ cmCustomCommandGenerator::cmCustomCommandGenerator(
       case cmDepfileFormat::MSBuildAdditionalInputs:
         argv.emplace_back("MSBuildAdditionalInputs");
         break;
+      case cmDepfileFormat::FastbuildExecInput:
+        argv.emplace_back("FastbuildExecInput");
+        break;
     }
     argv.push_back(this->LG->GetSourceDirectory());
     argv.push_back(this->LG->GetCurrentSourceDirectory());
@@ -447,6 +450,9 @@ std::string cmCustomCommandGenerator::GetInternalDepfileName(
     case cmDepfileFormat::MSBuildAdditionalInputs:
       extension = ".AdditionalInputs";
       break;
+    case cmDepfileFormat::FastbuildExecInput:
+      extension = ".bff";
+      break;
   }
   return cmStrCat(this->LG->GetBinaryDirectory(), "/CMakeFiles/d/",
                   hash.HashString(depfile), extension);
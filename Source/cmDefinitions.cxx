@@ -3,6 +3,7 @@
 #include "cmDefinitions.h"
 
 #include <cassert>
+#include <cstdint>
 #include <functional>
 #include <unordered_set>
 #include <utility>
@@ -11,16 +12,196 @@
 
 cmDefinitions::Def cmDefinitions::NoDef;
 
+namespace {
+// Every level of the trie consumes this many bits of the key hash.
+unsigned int const BitsPerLevel = 5;
+unsigned int const HashBits = sizeof(std::size_t) * 8;
+
+unsigned int PopCount(std::uint32_t v)
+{
+  v = v - ((v >> 1) & 0x55555555u);
+  v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+  return (((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+}
+
+std::size_t Hash(cm::string_view key)
+{
+  return std::hash<cm::string_view>{}(key);
+}
+}
+
+/** Entries and children are ordered by their bit in the maps.  Below the
+    last level all hash bits are used up, the entries collide there and
+    the maps are unused.  */
+struct cmDefinitions::Table::Node
+{
+  std::uint32_t EntryMap = 0;
+  std::uint32_t ChildMap = 0;
+  std::vector<Entry> Entries;
+  std::vector<std::shared_ptr<Node>> Children;
+};
+
+template <typename F>
+void cmDefinitions::Table::ForEach(Node const& node, F const& f)
+{
+  for (Entry const& entry : node.Entries) {
+    f(entry.first, entry.second);
+  }
+  for (auto const& child : node.Children) {
+    ForEach(*child, f);
+  }
+}
+
+cmDefinitions::Def const* cmDefinitions::Table::Find(cm::string_view key) const
+{
+  std::size_t const hash = Hash(key);
+  Node const* node = this->Root.get();
+  for (unsigned int shift = 0; node; shift += BitsPerLevel) {
+    if (shift >= HashBits) {
+      for (Entry const& entry : node->Entries) {
+        if (entry.first.view() == key) {
+          return &entry.second;
+        }
+      }
+      return nullptr;
+    }
+    std::uint32_t const bit = std::uint32_t(1) << ((hash >> shift) & 31);
+    if (node->EntryMap & bit) {
+      Entry const& entry =
+        node->Entries[PopCount(node->EntryMap & (bit - 1))];
+      return entry.first.view() == key ? &entry.second : nullptr;
+    }
+    if (!(node->ChildMap & bit)) {
+      return nullptr;
+    }
+    node = node->Children[PopCount(node->ChildMap & (bit - 1))].get();
+  }
+  return nullptr;
+}
+
+cmDefinitions::Table::Node& cmDefinitions::Table::Own(
+  std::shared_ptr<Node>& node)
+{
+  if (!node) {
+    node = std::make_shared<Node>();
+  } else if (node.use_count() > 1) {
+    node = std::make_shared<Node>(*node);
+  }
+  return *node;
+}
+
+void cmDefinitions::Table::Set(cm::String const& key, Def const& def)
+{
+  if (this->Set(this->Root, 0, Hash(key.view()), key, def)) {
+    ++this->Count;
+  }
+}
+
+bool cmDefinitions::Table::Set(std::shared_ptr<Node>& node,
+                               unsigned int shift, std::size_t hash,
+                               cm::String const& key, Def const& def)
+{
+  Node& n = Own(node);
+  if (shift >= HashBits) {
+    for (Entry& entry : n.Entries) {
+      if (entry.first.view() == key.view()) {
+        entry.second = def;
+        return false;
+      }
+    }
+    n.Entries.emplace_back(key, def);
+    return true;
+  }
+
+  std::uint32_t const bit = std::uint32_t(1) << ((hash >> shift) & 31);
+  if (n.ChildMap & bit) {
+    return this->Set(n.Children[PopCount(n.ChildMap & (bit - 1))],
+                     shift + BitsPerLevel, hash, key, def);
+  }
+  auto const entryIndex = PopCount(n.EntryMap & (bit - 1));
+  if (!(n.EntryMap & bit)) {
+    n.Entries.emplace(n.Entries.begin() + entryIndex, key, def);
+    n.EntryMap |= bit;
+    return true;
+  }
+  Entry& entry = n.Entries[entryIndex];
+  if (entry.first.view() == key.view()) {
+    entry.second = def;
+    return false;
+  }
+
+  // Another key lives in this slot, move both one level down.
+  std::shared_ptr<Node> child;
+  this->Set(child, shift + BitsPerLevel, Hash(entry.first.view()),
+            entry.first, entry.second);
+  this->Set(child, shift + BitsPerLevel, hash, key, def);
+  n.Entries.erase(n.Entries.begin() + entryIndex);
+  n.EntryMap &= ~bit;
+  n.Children.emplace(
+    n.Children.begin() + PopCount(n.ChildMap & (bit - 1)), std::move(child));
+  n.ChildMap |= bit;
+  return true;
+}
+
+void cmDefinitions::Table::Erase(cm::string_view key)
+{
+  if (this->Find(key) && this->Erase(this->Root, 0, Hash(key), key)) {
+    --this->Count;
+  }
+}
+
+bool cmDefinitions::Table::Erase(std::shared_ptr<Node>& node,
+                                 unsigned int shift, std::size_t hash,
+                                 cm::string_view key)
+{
+  Node& n = Own(node);
+  if (shift >= HashBits) {
+    for (auto it = n.Entries.begin(); it != n.Entries.end(); ++it) {
+      if (it->first.view() == key) {
+        n.Entries.erase(it);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::uint32_t const bit = std::uint32_t(1) << ((hash >> shift) & 31);
+  if (n.EntryMap & bit) {
+    n.Entries.erase(n.Entries.begin() + PopCount(n.EntryMap & (bit - 1)));
+    n.EntryMap &= ~bit;
+    return true;
+  }
+  auto const childIndex = PopCount(n.ChildMap & (bit - 1));
+  std::shared_ptr<Node>& child = n.Children[childIndex];
+  bool const erased = this->Erase(child, shift + BitsPerLevel, hash, key);
+  if (child->Entries.empty() && child->Children.empty()) {
+    n.Children.erase(n.Children.begin() + childIndex);
+    n.ChildMap &= ~bit;
+  }
+  return erased;
+}
+
+cmDefinitions::Def const* cmDefinitions::FindLocal(
+  const std::string& key) const
+{
+  if (Def const* def = this->Map.Find(key)) {
+    return def;
+  }
+  if (!this->Undefined.empty() &&
+      this->Undefined.find(cm::String::borrow(key)) !=
+        this->Undefined.end()) {
+    return &cmDefinitions::NoDef;
+  }
+  return nullptr;
+}
+
 cmDefinitions::Def const& cmDefinitions::GetInternal(const std::string& key,
                                                      StackIter begin,
                                                      StackIter end, bool raise)
 {
   assert(begin != end);
-  {
-    auto it = begin->Map.find(cm::String::borrow(key));
-    if (it != begin->Map.end()) {
-      return it->second;
-    }
+  if (Def const* def = begin->FindLocal(key)) {
+    return *def;
   }
   StackIter it = begin;
   ++it;
@@ -31,7 +212,13 @@ cmDefinitions::Def const& cmDefinitions::GetInternal(const std::string& key,
   if (!raise) {
     return def;
   }
-  return begin->Map.emplace(key, def).first->second;
+  if (!def.Value) {
+    begin->Undefined.insert(key);
+    return cmDefinitions::NoDef;
+  }
+  Def const copy = def;
+  begin->Map.Set(key, copy);
+  return *begin->Map.Find(key);
 }
 
 cmValue cmDefinitions::Get(const std::string& key, StackIter begin,
@@ -51,7 +238,7 @@ bool cmDefinitions::HasKey(const std::string& key, StackIter begin,
                            StackIter end)
 {
   for (StackIter it = begin; it != end; ++it) {
-    if (it->Map.find(cm::String::borrow(key)) != it->Map.end()) {
+    if (it->FindLocal(key)) {
       return true;
     }
   }
@@ -60,20 +247,25 @@ bool cmDefinitions::HasKey(const std::string& key, StackIter begin,
 
 cmDefinitions cmDefinitions::MakeClosure(StackIter begin, StackIter end)
 {
-  cmDefinitions closure;
-  std::unordered_set<cm::string_view> undefined;
+  std::vector<StackIter> scopes;
   for (StackIter it = begin; it != end; ++it) {
-    // Consider local definitions.
-    for (auto const& mi : it->Map) {
-      // Use this key if it is not already set or unset.
-      if (closure.Map.find(mi.first) == closure.Map.end() &&
-          undefined.find(mi.first.view()) == undefined.end()) {
-        if (mi.second.Value) {
-          closure.Map.insert(mi);
-        } else {
-          undefined.emplace(mi.first.view());
-        }
-      }
+    scopes.push_back(it);
+  }
+
+  // Share the table of the outermost scope and apply the inner scopes on
+  // top of it, the innermost one last.
+  cmDefinitions closure;
+  for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+    cmDefinitions const& scope = **it;
+    if (it == scopes.rbegin()) {
+      closure.Map = scope.Map;
+      continue;
+    }
+    scope.Map.ForEach([&closure](cm::String const& key, Def const& def) {
+      closure.Map.Set(key, def);
+    });
+    for (cm::String const& key : scope.Undefined) {
+      closure.Map.Erase(key.view());
     }
   }
   return closure;
@@ -86,12 +278,16 @@ std::vector<std::string> cmDefinitions::ClosureKeys(StackIter begin,
   std::unordered_set<cm::string_view> bound;
 
   for (StackIter it = begin; it != end; ++it) {
-    defined.reserve(defined.size() + it->Map.size());
-    for (auto const& mi : it->Map) {
-      // Use this key if it is not already set or unset.
-      if (bound.emplace(mi.first.view()).second && mi.second.Value) {
-        defined.push_back(*mi.first.str_if_stable());
-      }
+    defined.reserve(defined.size() + it->Map.Size());
+    // Use a key if it is not already set or unset.
+    it->Map.ForEach(
+      [&defined, &bound](cm::String const& key, Def const& /*unused*/) {
+        if (bound.emplace(key.view()).second) {
+          defined.push_back(*key.str_if_stable());
+        }
+      });
+    for (cm::String const& key : it->Undefined) {
+      bound.emplace(key.view());
     }
   }
 
@@ -100,10 +296,14 @@ std::vector<std::string> cmDefinitions::ClosureKeys(StackIter begin,
 
 void cmDefinitions::Set(const std::string& key, cm::string_view value)
 {
-  this->Map[key] = Def(value);
+  if (!this->Undefined.empty()) {
+    this->Undefined.erase(cm::String::borrow(key));
+  }
+  this->Map.Set(key, Def(value));
 }
 
 void cmDefinitions::Unset(const std::string& key)
 {
-  this->Map[key] = Def();
+  this->Map.Erase(key);
+  this->Undefined.insert(key);
 }
@@ -4,9 +4,12 @@
 
 #include "cmConfigure.h" // IWYU pragma: keep
 
+#include <cstddef>
 #include <functional>
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <cm/string_view>
@@ -20,7 +23,9 @@
  *
  * This stores the state of variable definitions (set or unset) for
  * one scope.  Sets are always local.  Gets search parent scopes
- * transitively and save results locally.
+ * transitively and save results locally.  The closure a directory
+ * starts with shares the definitions of its parent, a scope only copies
+ * the parts of the table it changes.
  */
 class cmDefinitions
 {
@@ -61,7 +66,48 @@ private:
   };
   static Def NoDef;
 
-  std::unordered_map<cm::String, Def> Map;
+  /** Persistent hash array mapped trie.  Copies share their nodes, a
+      modification copies the nodes on the path to the key first unless
+      the table owns them alone.  */
+  class Table
+  {
+  public:
+    Def const* Find(cm::string_view key) const;
+    void Set(cm::String const& key, Def const& def);
+    void Erase(cm::string_view key);
+    std::size_t Size() const { return this->Count; }
+
+    template <typename F>
+    void ForEach(F const& f) const
+    {
+      if (this->Root) {
+        ForEach(*this->Root, f);
+      }
+    }
+
+  private:
+    struct Node;
+    using Entry = std::pair<cm::String, Def>;
+
+    template <typename F>
+    static void ForEach(Node const& node, F const& f);
+
+    static Node& Own(std::shared_ptr<Node>& node);
+    bool Set(std::shared_ptr<Node>& node, unsigned int shift,
+             std::size_t hash, cm::String const& key, Def const& def);
+    bool Erase(std::shared_ptr<Node>& node, unsigned int shift,
+               std::size_t hash, cm::string_view key);
+
+    std::shared_ptr<Node> Root;
+    std::size_t Count = 0;
+  };
+
+  /** Defined variables.  */
+  Table Map;
+  /** Variables unset in this scope, hiding those of parent scopes.  */
+  std::unordered_set<cm::String> Undefined;
+
+  Def const* FindLocal(const std::string& key) const;
 
   static Def const& GetInternal(const std::string& key, StackIter begin,
                                 StackIter end, bool raise);
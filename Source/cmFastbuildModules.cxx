@@ -0,0 +1,280 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmFastbuildModules.h"
+
+#include <cctype>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+
+#include <cm3p/json/reader.h>
+#include <cm3p/json/value.h>
+#include <cm3p/json/writer.h>
+
+#include "cmsys/FStream.hxx"
+
+#include "cmCryptoHash.h"
+#include "cmGeneratedFileStream.h"
+#include "cmGlobalFastbuildGenerator.h"
+#include "cmStringAlgorithms.h"
+#include "cmSystemTools.h"
+
+namespace {
+bool ReadJson(std::string const& file, Json::Value& value, std::string& error)
+{
+  cmsys::ifstream fin(file.c_str(), std::ios::in | std::ios::binary);
+  if (!fin) {
+    error = cmStrCat("Unable to open \"", file, '"');
+    return false;
+  }
+  Json::CharReaderBuilder builder;
+  std::string errors;
+  if (!Json::parseFromStream(builder, fin, &value, &errors)) {
+    error = cmStrCat("Unable to parse \"", file, "\":\n", errors);
+    return false;
+  }
+  return true;
+}
+}
+
+void cmFastbuildModules::AddLinkedModules(Json::Value const& modules)
+{
+  if (!modules.isObject()) {
+    return;
+  }
+  for (auto const& name : modules.getMemberNames()) {
+    Json::Value const& module = modules[name];
+    this->Modules[name] = { module["file"].asString(),
+                            module["node"].asString() };
+  }
+}
+
+void cmFastbuildModules::AddSource(Source source, std::string const& moduleDir,
+                                   std::string const& topBinaryDir)
+{
+  // Modules of the target take precedence over those of linked targets.
+  for (cmSourceReqInfo const& provide : source.Info.Provides) {
+    std::string file = provide.CompiledModulePath;
+    if (file.empty()) {
+      file = cmStrCat(moduleDir, '/', provide.LogicalName);
+    }
+    Module module{ cmSystemTools::CollapseFullPath(file, topBinaryDir),
+                   source.Node };
+    this->Modules[provide.LogicalName] = module;
+    this->ProvidedModules[provide.LogicalName] = std::move(module);
+  }
+  this->Sources.push_back(std::move(source));
+}
+
+bool cmFastbuildModules::Collate(std::string& error)
+{
+  // Modules nobody provides are left to the compiler, Fortran's intrinsic
+  // modules for example.
+  std::unordered_multimap<std::string, std::string> dependencies;
+  this->Order.clear();
+  for (Source const& source : this->Sources) {
+    this->Order.push_back(source.Node);
+    std::set<std::string>& nodes = this->Dependencies[source.Node];
+    for (cmSourceReqInfo const& require : source.Info.Requires) {
+      auto module = this->Modules.find(require.LogicalName);
+      if (module != this->Modules.end() &&
+          module->second.Node != source.Node) {
+        nodes.insert(module->second.Node);
+        dependencies.emplace(source.Node, module->second.Node);
+      }
+    }
+  }
+
+  auto cycle =
+    cmGlobalFastbuildGenerator::SortByDependencies(this->Order, dependencies);
+  if (!cycle.empty()) {
+    error = cmStrCat("The modules of these object lists depend on each "
+                     "other in a cycle:\n  ",
+                     cmJoin(cycle, "\n  "));
+    return false;
+  }
+  return true;
+}
+
+std::set<std::string> cmFastbuildModules::GetDependencies(
+  std::string const& node) const
+{
+  auto it = this->Dependencies.find(node);
+  return it != this->Dependencies.end() ? it->second
+                                        : std::set<std::string>();
+}
+
+bool cmFastbuildModules::WriteModuleMap(std::ostream& os,
+                                        Source const& source,
+                                        std::string const& format,
+                                        std::string const& topBinaryDir) const
+{
+  if (format != "gcc") {
+    return false;
+  }
+
+  // Same format as the Ninja generator writes, see WriteDyndepFile().
+  os << "$root .\n";
+  auto writeModules = [&](std::vector<cmSourceReqInfo> const& modules) {
+    for (cmSourceReqInfo const& m : modules) {
+      auto module = this->Modules.find(m.LogicalName);
+      if (module != this->Modules.end()) {
+        os << m.LogicalName << ' '
+           << cmSystemTools::RelativePath(topBinaryDir, module->second.File)
+           << '\n';
+      }
+    }
+  };
+  writeModules(source.Info.Provides);
+  writeModules(source.Info.Requires);
+  return true;
+}
+
+Json::Value cmFastbuildModules::WriteModules() const
+{
+  Json::Value modules(Json::objectValue);
+  for (auto const& provided : this->ProvidedModules) {
+    Json::Value& module = modules[provided.first] = Json::objectValue;
+    module["file"] = provided.second.File;
+    module["node"] = provided.second.Node;
+  }
+  return modules;
+}
+
+std::string cmFastbuildModules::StructName(std::string const& node)
+{
+  std::string name = node;
+  for (char& c : name) {
+    if (!std::isalnum(static_cast<unsigned char>(c))) {
+      c = '_';
+    }
+  }
+  return name;
+}
+
+std::string cmFastbuildModules::Signature(
+  std::vector<std::string> const& nodes)
+{
+  cmCryptoHash hash(cmCryptoHash::AlgoSHA256);
+  return cmStrCat("// Object lists: ", hash.HashString(cmJoin(nodes, ";")));
+}
+
+void cmFastbuildModules::WriteFragment(
+  std::ostream& os, std::string const& signature,
+  std::vector<std::string> const& order,
+  std::map<std::string, std::set<std::string>> const& dependencies)
+{
+  os << signature << '\n';
+  for (std::string const& node : order) {
+    cmGlobalFastbuildGenerator::WriteCommand(
+      os, "ObjectList", cmGlobalFastbuildGenerator::Quote(node), 1);
+    cmGlobalFastbuildGenerator::Indent(os, 1);
+    os << "{\n";
+    cmGlobalFastbuildGenerator::Indent(os, 2);
+    os << "Using(." << StructName(node) << ")\n";
+    auto it = dependencies.find(node);
+    if (it != dependencies.end() && !it->second.empty()) {
+      std::vector<std::string> quoted;
+      for (std::string const& dependency : it->second) {
+        quoted.push_back(cmGlobalFastbuildGenerator::Quote(dependency));
+      }
+      cmGlobalFastbuildGenerator::WriteArray(os, "PreBuildDependencies",
+                                             quoted, "+", 2);
+    }
+    cmGlobalFastbuildGenerator::Indent(os, 1);
+    os << "}\n";
+  }
+}
+
+void cmFastbuildModules::InitializeFragment(
+  std::string const& fragment, std::vector<std::string> const& nodes)
+{
+  // Keep the order of the last scan as long as the object lists are the
+  // same, the fragment is rewritten by the next scan anyway.
+  std::string const signature = Signature(nodes);
+  {
+    cmsys::ifstream fin(fragment.c_str());
+    std::string line;
+    if (fin && cmSystemTools::GetLineFromStream(fin, line) &&
+        line == signature) {
+      return;
+    }
+  }
+  cmGeneratedFileStream fout(fragment);
+  fout.SetCopyIfDifferent(true);
+  WriteFragment(fout, signature, nodes, {});
+}
+
+int cmFastbuildModules::Run(std::string const& dependInfoFile)
+{
+  Json::Value tdi;
+  std::string error;
+  if (!ReadJson(dependInfoFile, tdi, error)) {
+    std::cerr << error << std::endl;
+    return 1;
+  }
+  std::string const topBinaryDir = tdi["dir-top-bld"].asString();
+  std::string const moduleDir = tdi["module-dir"].asString();
+  std::string const modmapFormat = tdi["modmap-format"].asString();
+
+  // Linked targets were collated first, a missing file provides nothing.
+  cmFastbuildModules modules;
+  for (Json::Value const& linked : tdi["linked-modules-files"]) {
+    Json::Value linkedModules;
+    if (cmSystemTools::FileExists(linked.asString()) &&
+        ReadJson(linked.asString(), linkedModules, error)) {
+      modules.AddLinkedModules(linkedModules);
+    }
+  }
+
+  std::vector<std::string> nodes;
+  for (Json::Value const& s : tdi["sources"]) {
+    Source source;
+    source.Node = s["node"].asString();
+    source.Object = s["object"].asString();
+    std::string const ddi = s["ddi"].asString();
+    if (!cmScanDepFormat_P1689_Parse(ddi, &source.Info)) {
+      std::cerr << "Unable to parse the module dependencies \"" << ddi
+                << '"' << std::endl;
+      return 1;
+    }
+    nodes.push_back(source.Node);
+    modules.AddSource(std::move(source), moduleDir, topBinaryDir);
+  }
+
+  if (!modules.Collate(error)) {
+    std::cerr << error << std::endl;
+    return 1;
+  }
+
+  if (!modmapFormat.empty()) {
+    for (Source const& source : modules.GetSources()) {
+      cmGeneratedFileStream mmf(cmStrCat(
+        cmSystemTools::CollapseFullPath(source.Object, topBinaryDir),
+        ".modmap"));
+      mmf.SetCopyIfDifferent(true);
+      if (!modules.WriteModuleMap(mmf, source, modmapFormat, topBinaryDir)) {
+        std::cerr << "Unknown module map format \"" << modmapFormat << '"'
+                  << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  {
+    cmGeneratedFileStream mf(tdi["modules-file"].asString());
+    mf.SetCopyIfDifferent(true);
+    mf << modules.WriteModules();
+  }
+
+  // Only a new order makes fbuild parse the build files again.
+  std::map<std::string, std::set<std::string>> dependencies;
+  for (std::string const& node : nodes) {
+    dependencies[node] = modules.GetDependencies(node);
+  }
+  cmGeneratedFileStream fragment(tdi["fragment"].asString());
+  fragment.SetCopyIfDifferent(true);
+  WriteFragment(fragment, Signature(nodes), modules.GetOrder(),
+                dependencies);
+  return 0;
+}
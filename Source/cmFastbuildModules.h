@@ -0,0 +1,98 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <iosfwd>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cmScanDepFormat.h"
+
+namespace Json {
+class Value;
+}
+
+/** \class cmFastbuildModules
+ * \brief Order the object lists of a target by the modules they use.
+ *
+ * FASTBuild reads its dependency graph once, before building anything.
+ * Sources using Fortran or C++ modules therefore get an ObjectList each,
+ * written to a module fragment included by the target. A first fbuild
+ * pass scans the sources and runs "cmake -E cmake_fastbuild_collate",
+ * which rewrites the fragment so that every ObjectList waits for the
+ * ones providing its modules. The build pass then reads the new order.
+ */
+class cmFastbuildModules
+{
+public:
+  struct Source
+  {
+    /// The ObjectList compiling the source.
+    std::string Node;
+    /// The object file and the scanner output for it.
+    std::string Object;
+    cmScanDepInfo Info;
+  };
+
+  /// Modules provided by a linked target, as written by WriteModules().
+  void AddLinkedModules(Json::Value const& modules);
+
+  /// Add the sources of the target, in the order the generator lists them.
+  void AddSource(Source source, std::string const& moduleDir,
+                 std::string const& topBinaryDir);
+
+  /// Order the sources by their modules, false on a dependency cycle.
+  bool Collate(std::string& error);
+
+  std::vector<std::string> const& GetOrder() const { return this->Order; }
+  std::set<std::string> GetDependencies(std::string const& node) const;
+
+  /// Module map of @a source in the @a format of the compiler.
+  bool WriteModuleMap(std::ostream& os, Source const& source,
+                      std::string const& format,
+                      std::string const& topBinaryDir) const;
+
+  /// The modules provided by the target, for its dependents.
+  Json::Value WriteModules() const;
+
+  std::vector<Source> const& GetSources() const { return this->Sources; }
+
+  /// Name of the variable holding the settings of ObjectList @a node.
+  static std::string StructName(std::string const& node);
+
+  /// First line of a fragment defining @a nodes.
+  static std::string Signature(std::vector<std::string> const& nodes);
+
+  /**
+   * Write the fragment defining the ObjectLists @a order, each using the
+   * struct the generator wrote for it and waiting for @a dependencies.
+   */
+  static void WriteFragment(
+    std::ostream& os, std::string const& signature,
+    std::vector<std::string> const& order,
+    std::map<std::string, std::set<std::string>> const& dependencies);
+
+  /// Write the unordered fragment unless @a fragment defines @a nodes.
+  static void InitializeFragment(std::string const& fragment,
+                                 std::vector<std::string> const& nodes);
+
+  /// Implementation of "cmake -E cmake_fastbuild_collate".
+  static int Run(std::string const& dependInfoFile);
+
+private:
+  struct Module
+  {
+    std::string File;
+    std::string Node;
+  };
+
+  std::vector<Source> Sources;
+  std::map<std::string, Module> Modules;
+  std::map<std::string, Module> ProvidedModules;
+  std::map<std::string, std::set<std::string>> Dependencies;
+  std::vector<std::string> Order;
+};
@@ -1,7 +1,11 @@
 #include "cmFastbuildNormalTargetGenerator.h"
 
+#include <cm3p/json/value.h>
+#include <cm3p/json/writer.h>
+
 #include "cmComputeLinkInformation.h"
 #include "cmCustomCommandGenerator.h"
+#include "cmFastbuildModules.h"
 #include "cmGeneratedFileStream.h"
 #include "cmGeneratorExpression.h"
 #include "cmGeneratorTarget.h"
@@ -12,12 +16,19 @@
 #include "cmOSXBundleGenerator.h"
 #include "cmRulePlaceholderExpander.h"
 #include "cmSourceFile.h"
+#include "cmStandardLevelResolver.h"
 #include "cmState.h"
 #include "cmStateDirectory.h"
+#include "cmTransformDepfile.h"
 
 namespace {
 struct Objects
 {
+  std::string inputFilesRoot;
+  std::string directory;
+  /// Set for a source scanned for modules, which has a list of its own.
+  std::string scanResult;
+  std::string object;
   std::vector<std::string> sourceFiles;
   std::set<std::string> extraOutputs;
   std::set<std::string> extraDependencies;
@@ -27,7 +38,10 @@ struct CompileCommand
 {
   std::string flags;
   bool usePCH = false;
+  bool allowCaching = true;
+  bool allowDistribution = true;
   std::map<std::string, Objects> objects;
+  std::map<std::string, Objects> unity;
 };
 
 void FilterSourceFiles(std::vector<cmSourceFile const*>& filteredSourceFiles,
@@ -46,8 +60,8 @@ void FilterSourceFiles(std::vector<cmSourceFile const*>& filteredSourceFiles,
 }
 
 cmFastbuildNormalTargetGenerator::cmFastbuildNormalTargetGenerator(
-  cmGeneratorTarget* gt)
-  : cmFastbuildTargetGenerator(gt)
+  cmGeneratorTarget* gt, const std::string& config)
+  : cmFastbuildTargetGenerator(gt, config)
 {
   this->OSXBundleGenerator = new cmOSXBundleGenerator(gt);
   this->OSXBundleGenerator->SetMacContentFolders(&this->MacContentFolders);
@@ -64,31 +78,35 @@ void cmFastbuildNormalTargetGenerator::DetectCompilerFlags(
 {
   const auto& configName = GetConfigName();
 
-  LocalCommonGenerator->GetTargetCompileFlags(
-    this->GeneratorTarget, configName, language, compileFlags, "");
+  // The target wide flags and include flags are computed once per language
+  // and cached, only the source properties are evaluated for each source.
+  compileFlags = this->GetFlags(language, configName);
 
   cmGeneratorExpressionInterpreter genexInterpreter(
     this->GetLocalGenerator(), configName, this->GeneratorTarget, language);
 
-  std::vector<std::string> includes;
   if (auto cincludes = source->GetProperty("INCLUDE_DIRECTORIES")) {
+    // The source include directories come first, the flags for the whole
+    // list must be computed again.
+    std::vector<std::string> includes;
     LocalCommonGenerator->AppendIncludeDirectories(
       includes, genexInterpreter.Evaluate(*cincludes, "INCLUDE_DIRECTORIES"),
       *source);
-  }
 
-  LocalCommonGenerator->GetIncludeDirectories(includes, this->GeneratorTarget,
-                                              language, configName);
+    LocalCommonGenerator->GetIncludeDirectories(
+      includes, this->GeneratorTarget, language, configName);
 
-  // Add include directory flags.
-  std::string includeFlags = LocalCommonGenerator->GetIncludeFlags(
-    includes, this->GeneratorTarget, language, configName,
-    false,
-    // full include paths for RC needed by cmcldeps
-    language == "RC" ? cmLocalGenerator::IncludePathStyle::Absolute
-                     : cmLocalGenerator::IncludePathStyle::Default);
+    std::string includeFlags = LocalCommonGenerator->GetIncludeFlags(
+      includes, this->GeneratorTarget, language, configName, false,
+      // full include paths for RC needed by cmcldeps
+      language == "RC" ? cmLocalGenerator::IncludePathStyle::Absolute
+                       : cmLocalGenerator::IncludePathStyle::Default);
 
-  LocalCommonGenerator->AppendFlags(compileFlags, includeFlags);
+    LocalCommonGenerator->AppendFlags(compileFlags, includeFlags);
+  } else {
+    LocalCommonGenerator->AppendFlags(compileFlags,
+                                      this->GetIncludes(language, configName));
+  }
 
   if (source) {
     if (auto cflags = source->GetProperty("COMPILE_FLAGS")) {
@@ -169,7 +187,7 @@ void cmFastbuildNormalTargetGenerator::DetectOutput(
       GeneratorTarget->GetCompilePDBDirectory(configName);
     if (targetNamesOut.targetOutputCompilePDBDir.empty()) {
       targetNamesOut.targetOutputCompilePDBDir =
-        GeneratorTarget->GetSupportDirectory() + "/";
+        this->GetObjectDirectory() + "/";
     }
   }
 
@@ -472,7 +490,8 @@ void cmFastbuildNormalTargetGenerator::DetectTargetObjectDependencies(
         std::vector<const cmSourceFile*> objFiles;
         objectTarget->GetObjectSources(objFiles, configName);
         if (!objFiles.empty())
-          objectLibs.insert(objectTarget->GetName() + "-objects");
+          objectLibs.insert(this->BuildAlias(objectTarget->GetName()) +
+                            "-objects");
       }
     }
   }
@@ -636,13 +655,133 @@ std::vector<std::string> cmFastbuildNormalTargetGenerator::GetLanguages()
   return std::vector<std::string>(languages.begin(), languages.end());
 }
 
+bool cmFastbuildNormalTargetGenerator::NeedModuleScan(
+  const std::string& language, const std::string& config) const
+{
+  if (language == "Fortran") {
+    return true;
+  }
+  if (language != "CXX" ||
+      !Makefile->IsOn("CMAKE_EXPERIMENTAL_CXX_MODULE_DYNDEP")) {
+    return false;
+  }
+  cmStandardLevelResolver standardResolver(Makefile);
+  return standardResolver.HaveStandardAvailable(
+    GeneratorTarget, "CXX", config, "cxx_std_20");
+}
+
+std::string cmFastbuildNormalTargetGenerator::GetDependInfoPath(
+  const std::string& language) const
+{
+  return cmStrCat(this->GetObjectDirectory(), '/', language,
+                  "DependInfo.json");
+}
+
+void cmFastbuildNormalTargetGenerator::GenerateModuleCollation(
+  const std::string& language, const std::vector<ScannedSource>& sources)
+{
+  const std::string& configName = this->GetConfigName();
+  const std::string targetName = this->BuildAlias(GeneratorTarget->GetName());
+  const std::string homeOutputDir = Makefile->GetHomeOutputDirectory();
+  const std::string fragmentName =
+    cmStrCat(targetName, '-', language, "-modules.bff");
+  const std::string fragment =
+    cmStrCat(homeOutputDir, '/',
+             cmGlobalFastbuildGenerator::FASTBUILD_FRAGMENTS_DIR, '/',
+             fragmentName);
+
+  // Same information as the Ninja generator's depend info, plus what the
+  // collation needs to write the module maps and the fragment.
+  Json::Value tdi(Json::objectValue);
+  tdi["language"] = language;
+  tdi["compiler-id"] =
+    Makefile->GetSafeDefinition(cmStrCat("CMAKE_", language, "_COMPILER_ID"));
+  std::string moduleDir;
+  if (language == "Fortran") {
+    moduleDir = GeneratorTarget->GetFortranModuleDirectory(homeOutputDir);
+    tdi["submodule-sep"] =
+      Makefile->GetSafeDefinition("CMAKE_Fortran_SUBMODULE_SEP");
+    tdi["submodule-ext"] =
+      Makefile->GetSafeDefinition("CMAKE_Fortran_SUBMODULE_EXT");
+  } else {
+    moduleDir = this->GetObjectDirectory();
+  }
+  if (moduleDir.empty()) {
+    moduleDir = Makefile->GetCurrentBinaryDirectory();
+  }
+  tdi["module-dir"] = moduleDir;
+  tdi["dir-top-bld"] = homeOutputDir;
+
+  // The scan parses the sources themselves rather than their preprocessed
+  // output, it needs the include directories and the defined names.
+  Json::Value& includeDirs = tdi["include-dirs"] = Json::arrayValue;
+  std::vector<std::string> includes;
+  this->GetLocalGenerator()->GetIncludeDirectories(includes, GeneratorTarget,
+                                                   language, configName);
+  for (const std::string& include : includes) {
+    includeDirs.append(include);
+  }
+  Json::Value& defines = tdi["defines"] = Json::arrayValue;
+  for (const auto& define :
+       GeneratorTarget->GetCompileDefinitions(configName, language)) {
+    defines.append(define.Value.substr(0, define.Value.find('=')));
+  }
+
+  tdi["modmap-format"] = language == "CXX"
+    ? Makefile->GetSafeDefinition("CMAKE_EXPERIMENTAL_CXX_MODULE_MAP_FORMAT")
+    : std::string();
+  tdi["fragment"] = fragment;
+  tdi["modules-file"] =
+    cmStrCat(this->GetObjectDirectory(), '/', language, "Modules.json");
+  Json::Value& linkedModules = tdi["linked-modules-files"] = Json::arrayValue;
+  for (const std::string& dir : this->GetLinkedTargetDirectories(configName)) {
+    linkedModules.append(
+      cmStrCat(dir, '/',
+               GetGlobalGenerator()->IsMultiConfig()
+                 ? cmStrCat(configName, '/')
+                 : std::string(),
+               language, "Modules.json"));
+  }
+
+  std::vector<std::string> nodes;
+  cmGlobalFastbuildGenerator::FastbuildExecNode collateNode;
+  Json::Value& tdiSources = tdi["sources"] = Json::arrayValue;
+  for (const ScannedSource& source : sources) {
+    Json::Value& s = tdiSources.append(Json::objectValue);
+    s["node"] = source.Node;
+    s["object"] = source.Object;
+    s["ddi"] = cmSystemTools::CollapseFullPath(source.ScanResult,
+                                               homeOutputDir);
+    nodes.push_back(source.Node);
+    collateNode.ExecInput.push_back(source.ScanResult);
+  }
+
+  const std::string dependInfo = this->GetDependInfoPath(language);
+  {
+    cmGeneratedFileStream tdif(dependInfo);
+    tdif.SetCopyIfDifferent(true);
+    tdif << tdi;
+  }
+  cmFastbuildModules::InitializeFragment(fragment, nodes);
+
+  collateNode.Name = cmStrCat(language, "_Modules_", targetName);
+  collateNode.ExecExecutable = cmSystemTools::GetCMakeCommand();
+  collateNode.ExecArguments =
+    cmStrCat("-E cmake_fastbuild_collate ",
+             this->GetLocalGenerator()->ConvertToOutputFormat(
+               ConvertToFastbuildPath(dependInfo), cmOutputConverter::SHELL));
+  collateNode.ExecOutput = ConvertToFastbuildPath(fragment);
+  this->CollateExecNodes.push_back(std::move(collateNode));
+  this->ModuleFragments.push_back(fragmentName);
+}
+
 std::vector<cmGlobalFastbuildGenerator::FastbuildObjectListNode>
 cmFastbuildNormalTargetGenerator::GenerateObjects()
 {
   std::map<std::string, cmGlobalFastbuildGenerator::FastbuildObjectListNode>
     objectsByName;
 
-  const std::string& targetName = GeneratorTarget->GetName();
+  const std::string targetName = this->BuildAlias(GeneratorTarget->GetName());
   const std::string& configName = this->GetConfigName();
 
   // Figure out the list of languages in use by this target
@@ -658,8 +797,55 @@ cmFastbuildNormalTargetGenerator::GenerateObjects()
     }
   }
 
+  // Map the sources CMake batched for UNITY_BUILD onto native Fastbuild
+  // Unity nodes, so Fastbuild decides the batches at build time and can
+  // isolate the files being edited. Injected code around each include
+  // cannot be expressed that way, keep CMake's unity sources then.
+  // Sources with OBJECT_DEPENDS are compiled on their own: the objects of a
+  // Unity node are not known here, so nothing could force them to rebuild
+  // when one of those files changes. CMake did not name their objects, do
+  // it the way it names the others.
+  std::map<std::string, std::vector<cmSourceFile const*>> unityBatches;
+  std::map<std::string, std::vector<cmSourceFile const*>> separateSources;
+  std::map<cmSourceFile const*, std::string> separateObjectNames;
+  std::set<std::string> unitySources;
+  const bool nativeUnity = GeneratorTarget->GetPropertyAsBool("UNITY_BUILD") &&
+    !GeneratorTarget->GetProperty("UNITY_BUILD_CODE_BEFORE_INCLUDE") &&
+    !GeneratorTarget->GetProperty("UNITY_BUILD_CODE_AFTER_INCLUDE") &&
+    !GeneratorTarget->GetProperty("UNITY_BUILD_UNIQUE_ID");
+  if (nativeUnity) {
+    for (const auto& source :
+         GeneratorTarget->GetKindedSources(configName).Sources) {
+      if (source.Kind == cmGeneratorTarget::SourceKindUnityBatched) {
+        cmSourceFile const* sf = source.Source.Value;
+        const std::string unityFile = sf->GetSafeProperty("UNITY_SOURCE_FILE");
+        if (sf->GetProperty("OBJECT_DEPENDS")) {
+          separateSources[sf->GetLanguage()].push_back(sf);
+          separateObjectNames[sf];
+        } else {
+          unityBatches[sf->GetLanguage()].push_back(sf);
+        }
+        unitySources.insert(unityFile);
+      }
+    }
+    this->GetLocalGenerator()->ComputeObjectFilenames(separateObjectNames,
+                                                      this->GeneratorTarget);
+  }
+  auto objectName = [this,
+                     &separateObjectNames](cmSourceFile const* srcFile) {
+    auto it = separateObjectNames.find(srcFile);
+    return it != separateObjectNames.end()
+      ? it->second
+      : this->GeneratorTarget->GetObjectName(srcFile);
+  };
+  const bool unityGroupMode =
+    GeneratorTarget->GetSafeProperty("UNITY_BUILD_MODE") == "GROUP";
+  const int unityBatchSize = std::atoi(
+    GeneratorTarget->GetSafeProperty("UNITY_BUILD_BATCH_SIZE").c_str());
+
   // Write the object list definitions for each language
   // stored in this target
+  int unityCount = 1;
   for (const std::string& language : languages) {
     const std::string pchSource =
       this->GeneratorTarget->GetPchSource(configName, language);
@@ -675,6 +861,14 @@ cmFastbuildNormalTargetGenerator::GenerateObjects()
     const std::string pchObject =
       this->GetGlobalGenerator()->ConvertToFastbuildPath(
         generatorTarget->GetPchFileObject(this->GetConfigName(), language));
+    // MSVC names the precompiled header with /Fp and its object with /Fo,
+    // GCC and Clang write the precompiled header itself to Fastbuild's %2.
+    const bool msvcPch =
+      Makefile->GetSafeDefinition(
+        cmStrCat("CMAKE_", language, "_COMPILER_FRONTEND_VARIANT")) ==
+        "MSVC" ||
+      Makefile->GetSafeDefinition(
+        cmStrCat("CMAKE_", language, "_COMPILER_ID")) == "MSVC";
     std::string pchOptions;
 
     cmRulePlaceholderExpander::RuleVariables compileObjectVars;
@@ -812,8 +1006,32 @@ cmFastbuildNormalTargetGenerator::GenerateObjects()
     rulePlaceholderExpander->SetTargetImpLib(
       FASTBUILD_DOLLAR_TAG "TargetOutputImplib" FASTBUILD_DOLLAR_TAG);
 
+    // TODO: Ask cmake the output objects and group by extension instead of
+    // doing this
+    std::string compilerOutputExtension;
+    if (language == "RC") {
+      compilerOutputExtension = ".res";
+    } else {
+      compilerOutputExtension = Makefile->GetSafeDefinition(
+        cmStrCat("CMAKE_", language, "_OUTPUT_EXTENSION"));
+    }
+
     std::map<std::string, CompileCommand> commandPermutations;
 
+    // Sources using modules get a scan node and an object list each, the
+    // module fragment orders the lists.
+    const bool scanModules = this->NeedModuleScan(language, configName);
+    std::string modmapFlag;
+    const std::string modmapFormat =
+      Makefile->GetSafeDefinition("CMAKE_EXPERIMENTAL_CXX_MODULE_MAP_FORMAT");
+    if (scanModules && language == "CXX" && !modmapFormat.empty()) {
+      modmapFlag = Makefile->GetRequiredDefinition(
+        "CMAKE_EXPERIMENTAL_CXX_MODULE_MAP_FLAG");
+    }
+    const std::string dependInfo =
+      ConvertToFastbuildPath(this->GetDependInfoPath(language));
+    std::vector<ScannedSource> scannedSources;
+
     // Source files
     {
       // get a list of source files
@@ -823,13 +1041,36 @@ cmFastbuildNormalTargetGenerator::GenerateObjects()
       std::vector<cmSourceFile const*> filteredObjectSources;
       FilterSourceFiles(filteredObjectSources, objectSources, language);
 
+      // Replace CMake's generated unity sources by the files they include
+      if (!unitySources.empty()) {
+        filteredObjectSources.erase(
+          std::remove_if(filteredObjectSources.begin(),
+                         filteredObjectSources.end(),
+                         [&unitySources](cmSourceFile const* sf) {
+                           return unitySources.count(sf->GetFullPath()) > 0;
+                         }),
+          filteredObjectSources.end());
+        const auto& separate = separateSources[language];
+        filteredObjectSources.insert(filteredObjectSources.end(),
+                                     separate.begin(), separate.end());
+      }
+      const auto& batchedSources = unityBatches[language];
+      const size_t batchedBegin = filteredObjectSources.size();
+      filteredObjectSources.insert(filteredObjectSources.end(),
+                                   batchedSources.begin(),
+                                   batchedSources.end());
+
       CompileCommand pchCommand;
+      std::unordered_map<std::string, std::string> expandedCommands;
       // Figure out the compilation commands for all
       // the translation units in the compilation.
       // Detect if one of them is a PreCompiledHeader
       // and extract it to be used in a precompiled header
       // generation step.
-      for (cmSourceFile const* srcFile : filteredObjectSources) {
+      for (size_t index = 0; index < filteredObjectSources.size(); ++index) {
+        cmSourceFile const* srcFile = filteredObjectSources[index];
+        const bool isUnityBatched = index >= batchedBegin;
+
         // Detect flags and defines
         std::string compilerFlags;
         DetectCompilerFlags(compilerFlags, srcFile, language);
@@ -838,40 +1079,201 @@ cmFastbuildNormalTargetGenerator::GenerateObjects()
 
         UnescapeFastbuildDefines(compileDefines);
 
-        compileObjectVars.Flags = compilerFlags.c_str();
-        compileObjectVars.Defines = compileDefines.c_str();
-
-        auto compileCmds_ = compileCmds;
-        for (auto& compileCmdStr : compileCmds_) {
-          rulePlaceholderExpander->ExpandRuleVariables(
-            (cmLocalFastbuildGenerator*)LocalCommonGenerator, compileCmdStr,
-            compileObjectVars);
+        std::string scanResult;
+        std::string objectFile;
+        if (scanModules && !isUnityBatched &&
+            srcFile->GetFullPath() != pchSource) {
+          std::string const objectPath = cmStrCat(
+            this->GetObjectDirectory(), '/', objectName(srcFile));
+          objectFile = ConvertToFastbuildPath(objectPath);
+          scanResult = cmStrCat(objectFile, ".ddi");
+
+          // Each source has a scan node and a deps node, see below.
+          cmGlobalFastbuildGenerator::FastbuildExecNode scanNode;
+          scanNode.Name =
+            cmStrCat(language, "_Scan_", targetName, '-',
+                     std::to_string(this->ScanExecNodes.size() / 2 + 1));
+          scanNode.ExecInput.push_back(
+            ConvertToFastbuildPath(srcFile->GetFullPath()));
+          scanNode.ExecOutput = scanResult;
+          // Generated files are read outside of the build, keep them
+          // absolute.
+          const std::string depfile = cmStrCat(objectPath, ".ddi.d");
+          const std::string depfileArg =
+            this->GetLocalGenerator()->ConvertToOutputFormat(
+              depfile, cmOutputConverter::SHELL);
+          if (language == "Fortran") {
+            // CMake's own parser follows the preprocessor directives.
+            scanNode.ExecExecutable = cmSystemTools::GetCMakeCommand();
+            scanNode.ExecArguments = cmStrCat(
+              "-E cmake_ninja_depends --tdi=", dependInfo,
+              " --lang=Fortran --pp=",
+              this->GetLocalGenerator()->ConvertToOutputFormat(
+                scanNode.ExecInput.front(), cmOutputConverter::SHELL),
+              " --dep=", depfileArg, " --obj=", objectFile,
+              " --ddi=" FASTBUILD_DOLLAR_TAG
+              "FB_INPUT_2_PLACEHOLDER" FASTBUILD_DOLLAR_TAG);
+          } else {
+            std::vector<std::string> scanCmds;
+            cmExpandList(Makefile->GetRequiredDefinition(
+                           "CMAKE_EXPERIMENTAL_CXX_SCANDEP_SOURCE"),
+                         scanCmds);
+            const std::string preprocessed = cmStrCat(objectFile, ".ddi.i");
+            const std::string source =
+              this->GetLocalGenerator()->ConvertToOutputFormat(
+                scanNode.ExecInput.front(), cmOutputConverter::SHELL);
+            cmRulePlaceholderExpander::RuleVariables scanVars =
+              compileObjectVars;
+            scanVars.Source = source.c_str();
+            scanVars.Object = objectFile.c_str();
+            scanVars.PreprocessedSource = preprocessed.c_str();
+            scanVars.DynDepFile = FASTBUILD_DOLLAR_TAG
+              "FB_INPUT_2_PLACEHOLDER" FASTBUILD_DOLLAR_TAG;
+            scanVars.DependencyFile = depfileArg.c_str();
+            scanVars.DependencyTarget = scanVars.DynDepFile;
+            scanVars.Flags = compilerFlags.c_str();
+            scanVars.Defines = compileDefines.c_str();
+            for (auto& scanCmd : scanCmds) {
+              rulePlaceholderExpander->ExpandRuleVariables(
+                (cmLocalFastbuildGenerator*)LocalCommonGenerator, scanCmd,
+                scanVars);
+            }
+            SplitExecutableAndFlags(BuildCommandLine(scanCmds),
+                                    scanNode.ExecExecutable,
+                                    scanNode.ExecArguments);
+          }
+
+          // The headers the scan read are inputs of the next scan. A node
+          // of its own converts the depfile to a fragment included in the
+          // scan node, fbuild reads it when it parses the build files again.
+          cmGlobalFastbuildGenerator::FastbuildExecNode depsNode;
+          depsNode.Name = cmStrCat(scanNode.Name, "-deps");
+          depsNode.ExecExecutable = cmSystemTools::GetCMakeCommand();
+          std::string const topSource =
+            this->GetLocalGenerator()->ConvertToOutputFormat(
+              this->GetLocalGenerator()->GetSourceDirectory(),
+              cmOutputConverter::SHELL);
+          std::string const topBinary =
+            this->GetLocalGenerator()->ConvertToOutputFormat(
+              this->GetLocalGenerator()->GetBinaryDirectory(),
+              cmOutputConverter::SHELL);
+          scanNode.DepfileFragment = cmStrCat(depfile, ".bff");
+          depsNode.ExecArguments = cmStrCat(
+            "-E cmake_transform_depfile ",
+            this->GetLocalGenerator()->ConvertToOutputFormat(
+              this->GetGlobalGenerator()->GetName(), cmOutputConverter::SHELL),
+            " FastbuildExecInput ", topSource, ' ', topSource, ' ', topBinary,
+            ' ', topBinary, ' ', depfileArg, ' ',
+            this->GetLocalGenerator()->ConvertToOutputFormat(
+              scanNode.DepfileFragment, cmOutputConverter::SHELL));
+          depsNode.ExecInput.push_back(depfile);
+          depsNode.ExecOutput = scanNode.DepfileFragment;
+          depsNode.PreBuildDependencies.insert(scanNode.Name);
+          if (!cmSystemTools::FileExists(scanNode.DepfileFragment) &&
+              !cmTransformDepfile(cmDepfileFormat::FastbuildExecInput,
+                                  *this->GetLocalGenerator(), depfile,
+                                  scanNode.DepfileFragment)) {
+            cmSystemTools::Error("Could not write " +
+                                 scanNode.DepfileFragment);
+          }
+          this->ScanExecNodes.push_back(std::move(scanNode));
+          this->ScanExecNodes.push_back(std::move(depsNode));
+
+          if (!modmapFlag.empty()) {
+            std::string flag = modmapFlag;
+            cmSystemTools::ReplaceString(flag, "<MODULE_MAP_FILE>",
+                                         cmStrCat(objectFile, ".modmap"));
+            LocalCommonGenerator->AppendFlags(compilerFlags, flag);
+          }
         }
-        auto compileCmd = BuildCommandLine(compileCmds_);
 
-        std::string executable, baseCompileFlags;
-        SplitExecutableAndFlags(compileCmd, executable, baseCompileFlags);
+        // Most sources share their flags and defines, expand the rule only
+        // once for each combination.
+        auto inserted = expandedCommands.emplace(
+          cmStrCat(compilerFlags, '\0', compileDefines), std::string());
+        if (inserted.second) {
+          compileObjectVars.Flags = compilerFlags.c_str();
+          compileObjectVars.Defines = compileDefines.c_str();
+
+          auto compileCmds_ = compileCmds;
+          for (auto& compileCmdStr : compileCmds_) {
+            rulePlaceholderExpander->ExpandRuleVariables(
+              (cmLocalFastbuildGenerator*)LocalCommonGenerator, compileCmdStr,
+              compileObjectVars);
+          }
+          auto compileCmd = BuildCommandLine(compileCmds_);
+
+          std::string executable;
+          SplitExecutableAndFlags(compileCmd, executable,
+                                  inserted.first->second);
+        }
+        const std::string& baseCompileFlags = inserted.first->second;
 
         if (srcFile->GetFullPath() == pchSource) {
           pchOptions = baseCompileFlags;
-          cmSystemTools::ReplaceString(pchOptions, "$FB_INPUT_2_PLACEHOLDER$",
-                                       pchObject);
+          if (msvcPch) {
+            cmSystemTools::ReplaceString(
+              pchOptions, "$FB_INPUT_2_PLACEHOLDER$", pchObject);
+          }
           continue;
         }
 
-        const bool usePCH = !pchReuseFrom && !pchSource.empty() &&
+        const bool usePCH = !pchSource.empty() &&
           !srcFile->GetProperty("SKIP_PRECOMPILE_HEADERS");
 
-        std::string const& directory = cmSystemTools::GetFilenamePath(
-          this->GeneratorTarget->GetObjectName(srcFile));
+        // Objects mirror the source tree below the directory the object
+        // name is relative to. Sources sharing that root go to a single
+        // ObjectList which preserves the layout through
+        // CompilerInputFilesRoot; names CMake had to mangle keep a list
+        // per object directory.
+        std::string const directory =
+          cmSystemTools::GetFilenamePath(objectName(srcFile));
+        std::string inputFilesRoot =
+          cmSystemTools::GetFilenamePath(srcFile->GetFullPath());
+        if (directory.empty() ||
+            cmHasSuffix(inputFilesRoot, cmStrCat('/', directory))) {
+          inputFilesRoot.resize(inputFilesRoot.size() - directory.size() -
+                                (directory.empty() ? 0 : 1));
+        } else {
+          inputFilesRoot.clear();
+        }
 
-        std::string configKey =
-          baseCompileFlags + "{|}" + (usePCH ? "usePCH" : "");
+        // Sources that must not be cached or distributed get object lists
+        // of their own, the source property overrides the target one.
+        auto fastbuildFlag = [this, srcFile](const std::string& prop) {
+          if (auto value = srcFile->GetProperty(prop)) {
+            return cmIsOn(*value);
+          }
+          if (auto value = this->GeneratorTarget->GetProperty(prop)) {
+            return cmIsOn(*value);
+          }
+          return true;
+        };
+        const bool allowCaching = fastbuildFlag("FASTBUILD_ALLOW_CACHING");
+        const bool allowDistribution =
+          fastbuildFlag("FASTBUILD_ALLOW_DISTRIBUTION");
+
+        std::string configKey = cmStrCat(
+          baseCompileFlags, "{|}", usePCH ? "usePCH" : "",
+          allowCaching ? "" : "{|}noCache",
+          allowDistribution ? "" : "{|}noDistribution");
         CompileCommand& command = commandPermutations[configKey];
-        auto& commandObjects = command.objects[directory];
+        auto& commandObjects = isUnityBatched
+          ? command.unity[unityGroupMode
+                            ? srcFile->GetSafeProperty("UNITY_GROUP")
+                            : std::string()]
+          : command.objects[cmStrCat(
+              inputFilesRoot.empty() ? directory : inputFilesRoot,
+              scanResult.empty() ? "" : "|", scanResult)];
+        commandObjects.inputFilesRoot = std::move(inputFilesRoot);
+        commandObjects.directory = directory;
+        commandObjects.scanResult = std::move(scanResult);
+        commandObjects.object = std::move(objectFile);
         commandObjects.sourceFiles.push_back(srcFile->GetFullPath());
         command.flags = baseCompileFlags;
         command.usePCH = usePCH;
+        command.allowCaching = allowCaching;
+        command.allowDistribution = allowDistribution;
 
         if (auto objectOutputs = srcFile->GetProperty("OBJECT_OUTPUTS")) {
           auto outputs = cmExpandedList(*objectOutputs);
@@ -897,12 +1299,16 @@ cmFastbuildNormalTargetGenerator::GenerateObjects()
     std::vector<std::string> configObjectGroups;
     int groupNameCount = 1;
     for (const auto& [key, command] : commandPermutations) {
-      for (const auto& [folderName, commandObjects] : command.objects) {
-        std::string targetCompileOutDirectory =
-          this->GeneratorTarget->GetSupportDirectory();
+      for (const auto& [_, commandObjects] : command.objects) {
+        std::string targetCompileOutDirectory = this->GetObjectDirectory();
+        const std::string& folderName = commandObjects.directory;
 
-        const auto ruleName = cmStrCat(objectGroupRuleName, "-", folderName,
-                                       "-", std::to_string(groupNameCount++));
+        const bool preserveLayout = !commandObjects.inputFilesRoot.empty();
+        const auto ruleName = preserveLayout
+          ? cmStrCat(objectGroupRuleName, "-",
+                     std::to_string(groupNameCount++))
+          : cmStrCat(objectGroupRuleName, "-", folderName, "-",
+                     std::to_string(groupNameCount++));
 
         cmGlobalFastbuildGenerator::FastbuildObjectListNode objectListNode;
 
@@ -910,13 +1316,24 @@ cmFastbuildNormalTargetGenerator::GenerateObjects()
 
         objectListNode.Name = ruleName;
         objectListNode.Compiler = "." + compilerId;
+        objectListNode.Language = language;
         objectListNode.CompilerOptions = command.flags;
         objectListNode.CompilerInputFiles =
           GetGlobalGenerator()->ConvertToFastbuildPath(
             commandObjects.sourceFiles);
-        objectListNode.CompilerOutputPath =
-          GetGlobalGenerator()->ConvertToFastbuildPath(
-            targetCompileOutDirectory + "/" + folderName);
+        if (preserveLayout) {
+          objectListNode.CompilerInputFilesRoot = cmStrCat(
+            GetGlobalGenerator()->ConvertToFastbuildPath(
+              commandObjects.inputFilesRoot),
+            '/');
+          objectListNode.CompilerOutputPath =
+            GetGlobalGenerator()->ConvertToFastbuildPath(
+              targetCompileOutDirectory);
+        } else {
+          objectListNode.CompilerOutputPath =
+            GetGlobalGenerator()->ConvertToFastbuildPath(
+              targetCompileOutDirectory + "/" + folderName);
+        }
 
         objectListNode.ObjectDependencies =
           std::vector<std::string>(commandObjects.extraDependencies.begin(),
@@ -926,26 +1343,94 @@ cmFastbuildNormalTargetGenerator::GenerateObjects()
                                    commandObjects.extraOutputs.end());
 
         if (!pchSource.empty() && command.usePCH) {
-          objectListNode.PCHInputFile =
-            GetGlobalGenerator()->ConvertToFastbuildPath(pchSource);
-          objectListNode.PCHOptions = pchOptions;
+          // With PRECOMPILE_HEADERS_REUSE_FROM only the header is named,
+          // WriteTargets() makes the list depend on the one building it.
+          if (!pchReuseFrom) {
+            objectListNode.PCHInputFile =
+              GetGlobalGenerator()->ConvertToFastbuildPath(pchSource);
+            objectListNode.PCHOptions = pchOptions;
+          }
           objectListNode.PCHOutputFile = pchFile;
         }
 
-        // TODO: Ask cmake the output objects and group by extension instead of
-        // doing this
-        if (language == "RC") {
-          objectListNode.CompilerOutputExtension = ".res";
-        } else {
-          std::string outputExtensionVar = std::string("CMAKE_") + language +
-            std::string("_OUTPUT_EXTENSION");
-          auto outputExtension =
-            Makefile->GetDefinition(outputExtensionVar);
+        objectListNode.CompilerOutputExtension = compilerOutputExtension;
+        objectListNode.AllowCaching = command.allowCaching;
+        objectListNode.AllowDistribution = command.allowDistribution;
 
-          objectListNode.CompilerOutputExtension = *outputExtension;
+        if (!commandObjects.scanResult.empty()) {
+          objectListNode.ScanModules = true;
+          scannedSources.push_back({ objectListNode.Name,
+                                     commandObjects.object,
+                                     commandObjects.scanResult });
         }
 
-        objectsByName[objectListNode.Name] = objectListNode;
+        objectsByName[objectListNode.Name] = std::move(objectListNode);
+      }
+
+      for (const auto& [_, commandObjects] : command.unity) {
+        const std::string unityOutputPath =
+          this->GetObjectDirectory() + "/Unity";
+
+        cmGlobalFastbuildGenerator::FastbuildUnityNode unityNode;
+        unityNode.Name = cmStrCat(language, "_Unity_", targetName, "-",
+                                  std::to_string(unityCount));
+        unityNode.UnityInputFiles =
+          GetGlobalGenerator()->ConvertToFastbuildPath(
+            commandObjects.sourceFiles);
+        unityNode.UnityOutputPath =
+          GetGlobalGenerator()->ConvertToFastbuildPath(unityOutputPath);
+        unityNode.UnityOutputPattern =
+          cmStrCat("fbuild_unity_", std::to_string(unityCount++), "_*",
+                   cmLocalGenerator::GetUnitySourceSuffix(language));
+        // Same batching as cmLocalGenerator::AddUnityFilesModeAuto
+        if (!unityGroupMode && unityBatchSize > 0) {
+          unityNode.UnityNumFiles = static_cast<int>(
+            (commandObjects.sourceFiles.size() + unityBatchSize - 1) /
+            unityBatchSize);
+        }
+        unityNode.UnityInputIsolateWritableFiles =
+          Makefile->IsOn("CMAKE_FASTBUILD_UNITY_ISOLATE_WRITABLE_FILES");
+        unityNode.UnityInputIsolateWritableFilesLimit = std::atoi(
+          Makefile
+            ->GetSafeDefinition(
+              "CMAKE_FASTBUILD_UNITY_ISOLATE_WRITABLE_FILES_LIMIT")
+            .c_str());
+        if (cmValue isolateListFile = Makefile->GetDefinition(
+              "CMAKE_FASTBUILD_UNITY_ISOLATE_LIST_FILE")) {
+          unityNode.UnityInputIsolateListFile =
+            GetGlobalGenerator()->ConvertToFastbuildPath(*isolateListFile);
+        }
+
+        cmGlobalFastbuildGenerator::FastbuildObjectListNode objectListNode;
+        objectListNode.Name =
+          cmStrCat(objectGroupRuleName, "-Unity-",
+                   std::to_string(groupNameCount++));
+        configObjectGroups.push_back(objectListNode.Name);
+        objectListNode.Compiler = "." + compilerId;
+        objectListNode.Language = language;
+        objectListNode.CompilerOptions = command.flags;
+        objectListNode.CompilerInputUnity = unityNode.Name;
+        objectListNode.CompilerOutputPath = unityNode.UnityOutputPath;
+        objectListNode.CompilerOutputExtension = compilerOutputExtension;
+        objectListNode.AllowCaching = command.allowCaching;
+        objectListNode.AllowDistribution = command.allowDistribution;
+        objectListNode.ObjectDependencies =
+          std::vector<std::string>(commandObjects.extraDependencies.begin(),
+                                   commandObjects.extraDependencies.end());
+        objectListNode.ObjectOutputs =
+          std::vector<std::string>(commandObjects.extraOutputs.begin(),
+                                   commandObjects.extraOutputs.end());
+        if (!pchSource.empty() && command.usePCH) {
+          if (!pchReuseFrom) {
+            objectListNode.PCHInputFile =
+              GetGlobalGenerator()->ConvertToFastbuildPath(pchSource);
+            objectListNode.PCHOptions = pchOptions;
+          }
+          objectListNode.PCHOutputFile = pchFile;
+        }
+
+        objectsByName[objectListNode.Name] = std::move(objectListNode);
+        UnityNodes.push_back(std::move(unityNode));
       }
     }
 
@@ -960,6 +1445,9 @@ cmFastbuildNormalTargetGenerator::GenerateObjects()
 
     configObjectGroups.insert(configObjectGroups.end(), ExtraFiles.begin(),
                               ExtraFiles.end());
+    if (!scannedSources.empty()) {
+      this->GenerateModuleCollation(language, scannedSources);
+    }
     if (!configObjectGroups.empty()) {
       // TODO: Write an alias for this object group to group them all together
     }
@@ -1001,7 +1489,7 @@ cmFastbuildNormalTargetGenerator::GenerateObjects()
 
   std::vector<cmGlobalFastbuildGenerator::FastbuildObjectListNode> objects;
   for (const auto& name : objectNames)
-    objects.push_back(objectsByName.at(name));
+    objects.push_back(std::move(objectsByName.at(name)));
 
   return objects;
 }
@@ -1040,7 +1528,7 @@ cmFastbuildNormalTargetGenerator::GenerateLink(
     }
   }
 
-  const auto targetName = GeneratorTarget->GetName();
+  const auto targetName = this->BuildAlias(GeneratorTarget->GetName());
 
   const std::string& configName = this->GetConfigName();
 
@@ -1140,7 +1628,9 @@ void cmFastbuildNormalTargetGenerator::Generate()
   const std::string& configName = this->GetConfigName();
 
   cmGlobalFastbuildGenerator::FastbuildTarget fastbuildTarget;
-  fastbuildTarget.Name = GeneratorTarget->GetName();
+  fastbuildTarget.Name = this->BuildAlias(GeneratorTarget->GetName());
+  fastbuildTarget.Config = configName;
+  fastbuildTarget.GeneratorTarget = this->GeneratorTarget;
 
   // Get all dependencies
   cmTargetDependSet const& targetDeps =
@@ -1151,13 +1641,14 @@ void cmFastbuildNormalTargetGenerator::Generate()
     } else if (depTarget->GetType() == cmStateEnums::GLOBAL_TARGET) {
       const cmGeneratorTarget& t = *depTarget;
       fastbuildTarget.Dependencies.push_back(
-        GetGlobalGenerator()->GetTargetName(&t));
+        this->BuildAlias(GetGlobalGenerator()->GetTargetName(&t)));
     } else {
-      fastbuildTarget.Dependencies.push_back(depTarget->GetName());
+      fastbuildTarget.Dependencies.push_back(
+        this->BuildAlias(depTarget->GetName()));
     }
   }
 
-  const std::string objPath = GetGeneratorTarget()->GetSupportDirectory();
+  const std::string objPath = this->GetObjectDirectory();
   fastbuildTarget.Variables["TargetOutDir"] =
     "\"" + ConvertToFastbuildPath(objPath) + "\"";
 
@@ -1175,7 +1666,7 @@ void cmFastbuildNormalTargetGenerator::Generate()
     std::string targetOutCompilePDBPath =
       GeneratorTarget->GetCompilePDBPath(configName);
     if (targetOutCompilePDBPath.empty()) {
-      targetOutCompilePDBPath = GeneratorTarget->GetSupportDirectory() + "/" +
+      targetOutCompilePDBPath = this->GetObjectDirectory() + "/" +
         GeneratorTarget->GetPDBName(configName);
     }
     targetOutCompilePDBPath =
@@ -1193,6 +1684,10 @@ void cmFastbuildNormalTargetGenerator::Generate()
   fastbuildTarget.PostBuildExecNodes = GenerateCommands("PostBuild");
   fastbuildTarget.ExecNodes = GenerateCommands();
   fastbuildTarget.ObjectListNodes = GenerateObjects();
+  fastbuildTarget.UnityNodes = std::move(this->UnityNodes);
+  fastbuildTarget.ScanExecNodes = std::move(this->ScanExecNodes);
+  fastbuildTarget.CollateExecNodes = std::move(this->CollateExecNodes);
+  fastbuildTarget.ModuleFragments = std::move(this->ModuleFragments);
   fastbuildTarget.LinkerNodes = GenerateLink(fastbuildTarget.ObjectListNodes);
 
 #ifdef _WIN32
@@ -1235,6 +1730,11 @@ void cmFastbuildNormalTargetGenerator::Generate()
     " --target \"", targetName, "\" --config ", configName);
   VCXProject.ProjectRebuildCommand =
     cmStrCat(VCXProject.ProjectBuildCommand, " -- -clean");
+  // Multi-config builds get the projects of the default configuration.
+  const std::string& defaultConfig = GetGlobalGenerator()->DefaultFileConfig;
+  if (!defaultConfig.empty() && defaultConfig != configName) {
+    fastbuildTarget.VCXProjects.clear();
+  }
 #endif
 
   fastbuildTarget.IsGlobal =
@@ -1262,7 +1762,7 @@ void cmFastbuildNormalTargetGenerator::Generate()
     execNode.ExecOutput = ConvertToFastbuildPath(mdi->DefFile);
     execNode.ExecInput.push_back(ConvertToFastbuildPath(obj_list_file));
 
-    fastbuildTarget.PreLinkExecNodes.push_back(execNode);
+    fastbuildTarget.PreLinkExecNodes.push_back(std::move(execNode));
 
     // create a list of obj files for the -E __create_def to read
     cmGeneratedFileStream fout(obj_list_file);
@@ -1307,6 +1807,6 @@ void cmFastbuildNormalTargetGenerator::Generate()
     objects.Targets.insert(object.Name);
   }
   if (!objects.Targets.empty())
-    fastbuildTarget.AliasNodes.push_back(objects);
-  GetLocalGenerator()->AddTarget(fastbuildTarget);
+    fastbuildTarget.AliasNodes.push_back(std::move(objects));
+  GetLocalGenerator()->AddTarget(std::move(fastbuildTarget));
 }
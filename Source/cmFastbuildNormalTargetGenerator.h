@@ -13,7 +13,8 @@ class cmOSXBundleGenerator;
 class cmFastbuildNormalTargetGenerator : public cmFastbuildTargetGenerator
 {
 public:
-  cmFastbuildNormalTargetGenerator(cmGeneratorTarget* gt);
+  cmFastbuildNormalTargetGenerator(cmGeneratorTarget* gt,
+                                   const std::string& config);
   ~cmFastbuildNormalTargetGenerator();
 
   void Generate() override;
@@ -58,6 +59,26 @@ private:
   void ComputeLinkCmds(std::vector<std::string>& linkCmds,
                        std::string configName);
 
+  /// Fortran sources, and C++ ones with CMAKE_EXPERIMENTAL_CXX_MODULE_DYNDEP,
+  /// compile after the sources providing the modules they use.
+  bool NeedModuleScan(const std::string& language,
+                      const std::string& config) const;
+
+  struct ScannedSource
+  {
+    std::string Node;
+    std::string Object;
+    std::string ScanResult;
+  };
+
+  /// Path of the file describing the module scan of @a language.
+  std::string GetDependInfoPath(const std::string& language) const;
+
+  /// Write the depend info and the initial module fragment of @a language
+  /// and add the node collating the scan results.
+  void GenerateModuleCollation(const std::string& language,
+                               const std::vector<ScannedSource>& sources);
+
   std::string ComputeDefines(const cmSourceFile* source,
                              const std::string& configName,
                              const std::string& language);
@@ -76,6 +97,14 @@ private:
 
   static void EnsureDirectoryExists(const std::string& path,
                                     const char* homeOutputDirectory);
+
+  /// Unity nodes consumed by the object lists from GenerateObjects().
+  std::vector<cmGlobalFastbuildGenerator::FastbuildUnityNode> UnityNodes;
+
+  /// Module scanning of the object lists from GenerateObjects().
+  std::vector<cmGlobalFastbuildGenerator::FastbuildExecNode> ScanExecNodes;
+  std::vector<cmGlobalFastbuildGenerator::FastbuildExecNode> CollateExecNodes;
+  std::vector<std::string> ModuleFragments;
 };
 
 #endif // cmFastbuildNormalTargetGenerator_h
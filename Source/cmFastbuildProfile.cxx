@@ -0,0 +1,315 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmFastbuildProfile.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+
+#include <cm3p/json/reader.h>
+#include <cm3p/json/value.h>
+
+#include "cmsys/FStream.hxx"
+
+#include "cmGlobalFastbuildGenerator.h"
+#include "cmStringAlgorithms.h"
+#include "cmSystemTools.h"
+
+namespace {
+bool ReadJson(std::string const& file, Json::Value& value, std::string& error)
+{
+  cmsys::ifstream fin(file.c_str());
+  if (!fin) {
+    error = cmStrCat("Unable to open \"", file, '"');
+    return false;
+  }
+  Json::CharReaderBuilder builder;
+  std::string errors;
+  if (!Json::parseFromStream(builder, fin, &value, &errors)) {
+    error = cmStrCat("Unable to parse \"", file, "\":\n", errors);
+    return false;
+  }
+  return true;
+}
+}
+
+bool cmFastbuildProfile::LoadNodeMap(Json::Value const& nodeMap,
+                                     std::string& error)
+{
+  if (!nodeMap.isObject() || !nodeMap["version"].isInt() ||
+      nodeMap["version"].asInt() != 1) {
+    error = "Unsupported node map, regenerate the build system.";
+    return false;
+  }
+  this->BuildDirectory = nodeMap["buildDirectory"].asString();
+
+  Json::Value const& targets = nodeMap["targets"];
+  for (auto const& name : targets.getMemberNames()) {
+    Json::Value const& target = targets[name];
+    Target& t = this->Targets[name];
+    t.Backtrace = target["backtrace"].asString();
+    for (Json::Value const& dependency : target["dependencies"]) {
+      t.Dependencies.push_back(dependency.asString());
+    }
+  }
+
+  for (Json::Value const& node : nodeMap["nodes"]) {
+    std::string const target = node["target"].asString();
+    this->NodeTargets[node["name"].asString()] = target;
+    for (Json::Value const& output : node["outputs"]) {
+      this->OutputTargets[this->Normalize(output.asString())] = target;
+    }
+    if (node.isMember("outputDirectory")) {
+      this->DirectoryTargets[this->Normalize(
+        node["outputDirectory"].asString())] = target;
+    }
+  }
+  return true;
+}
+
+bool cmFastbuildProfile::LoadProfile(Json::Value const& profile,
+                                     std::string& error)
+{
+  // Chrome trace format, either the bare event array or an object.
+  Json::Value const& events =
+    profile.isObject() ? profile["traceEvents"] : profile;
+  if (!events.isArray()) {
+    error = "The profile is not in the Chrome trace event format.";
+    return false;
+  }
+
+  // Duration events are complete ("X") or begin/end pairs per thread.
+  std::map<std::string, std::vector<std::pair<std::string, double>>> open;
+  for (Json::Value const& event : events) {
+    if (!event.isObject() || !event["ts"].isNumeric()) {
+      continue;
+    }
+    std::string const phase = event["ph"].asString();
+    double const ts = event["ts"].asDouble() / 1e6;
+    if (phase == "X") {
+      this->AddJob(event["name"].asString(), ts,
+                   event["dur"].asDouble() / 1e6);
+    } else if (phase == "B" || phase == "E") {
+      auto& stack = open[cmStrCat(event["pid"].toStyledString(), '/',
+                                  event["tid"].toStyledString())];
+      if (phase == "B") {
+        stack.emplace_back(event["name"].asString(), ts);
+      } else if (!stack.empty()) {
+        this->AddJob(stack.back().first, stack.back().second,
+                     ts - stack.back().second);
+        stack.pop_back();
+      }
+    }
+  }
+  return true;
+}
+
+std::string cmFastbuildProfile::Normalize(std::string path) const
+{
+  std::replace(path.begin(), path.end(), '\\', '/');
+  path = cmSystemTools::CollapseFullPath(path, this->BuildDirectory);
+  if (path.size() > 1 && path.back() == '/') {
+    path.pop_back();
+  }
+#ifdef _WIN32
+  path = cmSystemTools::LowerCase(path);
+#endif
+  return path;
+}
+
+std::string cmFastbuildProfile::FindTarget(std::string const& jobName) const
+{
+  auto node = this->NodeTargets.find(jobName);
+  if (node != this->NodeTargets.end()) {
+    return node->second;
+  }
+
+  // Jobs are usually named after the file they produce. Objects are only
+  // known by the directory of their object list.
+  std::string path = this->Normalize(jobName);
+  auto output = this->OutputTargets.find(path);
+  if (output != this->OutputTargets.end()) {
+    return output->second;
+  }
+  for (std::string dir = cmSystemTools::GetFilenamePath(path);
+       !dir.empty() && dir != path;
+       path = dir, dir = cmSystemTools::GetFilenamePath(dir)) {
+    auto directory = this->DirectoryTargets.find(dir);
+    if (directory != this->DirectoryTargets.end()) {
+      return directory->second;
+    }
+  }
+  return std::string();
+}
+
+void cmFastbuildProfile::AddJob(std::string const& name, double start,
+                                double duration)
+{
+  double const end = start + duration;
+  if (this->Jobs++ == 0) {
+    this->BuildStart = start;
+    this->BuildEnd = end;
+  }
+  this->BuildStart = std::min(this->BuildStart, start);
+  this->BuildEnd = std::max(this->BuildEnd, end);
+
+  auto target = this->Targets.find(this->FindTarget(name));
+  if (target == this->Targets.end()) {
+    ++this->UnattributedJobs;
+    this->UnattributedCpu += duration;
+    return;
+  }
+  Target& t = target->second;
+  if (t.Jobs++ == 0) {
+    t.Start = start;
+    t.End = end;
+  }
+  t.Cpu += duration;
+  t.Start = std::min(t.Start, start);
+  t.End = std::max(t.End, end);
+}
+
+double cmFastbuildProfile::ComputeCriticalPath(
+  std::string const& name, std::map<std::string, double>& paths,
+  std::map<std::string, std::string>& next) const
+{
+  auto known = paths.find(name);
+  if (known != paths.end()) {
+    return known->second;
+  }
+  // Guard against cycles, the generator rejects them anyway.
+  paths[name] = 0;
+
+  Target const& target = this->Targets.at(name);
+  double longest = 0;
+  double ready = target.Start;
+  for (std::string const& dependency : target.Dependencies) {
+    auto it = this->Targets.find(dependency);
+    if (it == this->Targets.end()) {
+      continue;
+    }
+    double const path = this->ComputeCriticalPath(dependency, paths, next);
+    if (path > longest) {
+      longest = path;
+      next[name] = dependency;
+    }
+    if (it->second.Jobs) {
+      ready = std::max(ready, it->second.End);
+    }
+  }
+  // Only the time after the dependencies finished extends the path.
+  double const own = target.Jobs ? std::max(target.End - ready, 0.0) : 0;
+  return paths[name] = longest + own;
+}
+
+std::vector<cmFastbuildProfile::TargetTimes> cmFastbuildProfile::Summarize()
+  const
+{
+  std::map<std::string, double> paths;
+  std::map<std::string, std::string> next;
+  std::vector<TargetTimes> summary;
+  for (auto const& [name, target] : this->Targets) {
+    if (target.Jobs == 0) {
+      continue;
+    }
+    TargetTimes times;
+    times.Name = name;
+    times.Backtrace = target.Backtrace;
+    times.Jobs = target.Jobs;
+    times.Cpu = target.Cpu;
+    times.Wall = target.End - target.Start;
+    times.CriticalPath = this->ComputeCriticalPath(name, paths, next);
+    summary.push_back(std::move(times));
+  }
+  std::stable_sort(summary.begin(), summary.end(),
+                   [](TargetTimes const& l, TargetTimes const& r) {
+                     return l.Cpu > r.Cpu;
+                   });
+  return summary;
+}
+
+std::vector<std::string> cmFastbuildProfile::GetCriticalPath() const
+{
+  std::map<std::string, double> paths;
+  std::map<std::string, std::string> next;
+  std::string last;
+  double longest = 0;
+  for (auto const& target : this->Targets) {
+    double const path = this->ComputeCriticalPath(target.first, paths, next);
+    if (path > longest) {
+      longest = path;
+      last = target.first;
+    }
+  }
+
+  // Follow the dependencies back, skipping targets without jobs.
+  std::vector<std::string> chain;
+  while (!last.empty()) {
+    if (this->Targets.at(last).Jobs) {
+      chain.push_back(last);
+    }
+    auto it = next.find(last);
+    last = it != next.end() ? it->second : std::string();
+  }
+  std::reverse(chain.begin(), chain.end());
+  return chain;
+}
+
+void cmFastbuildProfile::WriteReport(std::ostream& os) const
+{
+  std::vector<TargetTimes> const summary = this->Summarize();
+  std::size_t width = 6;
+  double cpu = this->UnattributedCpu;
+  for (TargetTimes const& times : summary) {
+    width = std::max(width, times.Name.size());
+    cpu += times.Cpu;
+  }
+
+  os << std::fixed << std::setprecision(2);
+  os << this->Jobs << " jobs, " << cpu << "s CPU, "
+     << this->BuildEnd - this->BuildStart << "s elapsed\n\n";
+
+  os << std::left << std::setw(static_cast<int>(width)) << "Target"
+     << std::right << "  " << std::setw(6) << "Jobs" << "  " << std::setw(10)
+     << "CPU [s]" << "  " << std::setw(10) << "Wall [s]" << "  "
+     << std::setw(10) << "Path [s]"
+     << "  Defined at\n";
+  for (TargetTimes const& times : summary) {
+    os << std::left << std::setw(static_cast<int>(width)) << times.Name
+       << std::right << "  " << std::setw(6) << times.Jobs << "  "
+       << std::setw(10) << times.Cpu << "  " << std::setw(10) << times.Wall
+       << "  " << std::setw(10) << times.CriticalPath << "  "
+       << times.Backtrace << '\n';
+  }
+  if (this->UnattributedJobs) {
+    os << "\nNot attributed to a target: " << this->UnattributedJobs
+       << " jobs, " << this->UnattributedCpu << "s CPU\n";
+  }
+
+  std::vector<std::string> const path = this->GetCriticalPath();
+  if (!path.empty()) {
+    os << "\nCritical path: " << cmJoin(path, " -> ") << '\n';
+  }
+}
+
+int cmFastbuildProfile::Run(std::string const& profileFile,
+                            std::string const& buildDir)
+{
+  std::string const nodeMapFile = cmStrCat(
+    buildDir, '/', cmGlobalFastbuildGenerator::FASTBUILD_NODE_MAP_FILE);
+
+  cmFastbuildProfile profile;
+  Json::Value nodeMap;
+  Json::Value trace;
+  std::string error;
+  if (!ReadJson(nodeMapFile, nodeMap, error) ||
+      !profile.LoadNodeMap(nodeMap, error) ||
+      !ReadJson(profileFile, trace, error) ||
+      !profile.LoadProfile(trace, error)) {
+    std::cerr << error << std::endl;
+    return 1;
+  }
+  profile.WriteReport(std::cout);
+  return 0;
+}
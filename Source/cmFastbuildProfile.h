@@ -0,0 +1,83 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Json {
+class Value;
+}
+
+/** \class cmFastbuildProfile
+ * \brief Attribute the jobs of a FASTBuild profile to CMake targets.
+ *
+ * Joins the node map written by the Fastbuild generator with the Chrome
+ * trace written by "fbuild -profile" and sums the jobs per target.
+ */
+class cmFastbuildProfile
+{
+public:
+  struct TargetTimes
+  {
+    std::string Name;
+    std::string Backtrace;
+    std::size_t Jobs = 0;
+    /// Sum of the job durations, in seconds.
+    double Cpu = 0;
+    /// From the start of the first job to the end of the last one.
+    double Wall = 0;
+    /// Longest chain of dependent targets ending here, counting for each
+    /// the time it ran after its dependencies finished.
+    double CriticalPath = 0;
+  };
+
+  bool LoadNodeMap(Json::Value const& nodeMap, std::string& error);
+  bool LoadProfile(Json::Value const& profile, std::string& error);
+
+  /// Targets with at least one job, the most expensive first.
+  std::vector<TargetTimes> Summarize() const;
+
+  /// The chain of targets with the longest critical path, first to last.
+  std::vector<std::string> GetCriticalPath() const;
+
+  void WriteReport(std::ostream& os) const;
+
+  /// Implementation of "cmake -E fastbuild_profile".
+  static int Run(std::string const& profileFile, std::string const& buildDir);
+
+private:
+  struct Target
+  {
+    std::string Backtrace;
+    std::vector<std::string> Dependencies;
+    std::size_t Jobs = 0;
+    double Cpu = 0;
+    double Start = 0;
+    double End = 0;
+  };
+
+  std::string Normalize(std::string path) const;
+  std::string FindTarget(std::string const& jobName) const;
+  void AddJob(std::string const& name, double start, double duration);
+  double ComputeCriticalPath(std::string const& name,
+                             std::map<std::string, double>& paths,
+                             std::map<std::string, std::string>& next) const;
+
+  std::string BuildDirectory;
+  std::map<std::string, Target> Targets;
+  std::map<std::string, std::string> NodeTargets;
+  std::map<std::string, std::string> OutputTargets;
+  std::map<std::string, std::string> DirectoryTargets;
+
+  std::size_t Jobs = 0;
+  std::size_t UnattributedJobs = 0;
+  double UnattributedCpu = 0;
+  double BuildStart = 0;
+  double BuildEnd = 0;
+};
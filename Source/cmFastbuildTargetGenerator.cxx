@@ -12,6 +12,7 @@
 #include "cmOSXBundleGenerator.h"
 #include "cmRulePlaceholderExpander.h"
 #include "cmSourceFile.h"
+#include "cmTransformDepfile.h"
 
 #define FASTBUILD_DOLLAR_TAG "FASTBUILD_DOLLAR_TAG"
 
@@ -19,7 +20,7 @@ cmFastbuildTargetGenerator::CustomCommandAliasMap
   cmFastbuildTargetGenerator::s_customCommandAliases;
 
 cmFastbuildTargetGenerator* cmFastbuildTargetGenerator::New(
-  cmGeneratorTarget* target)
+  cmGeneratorTarget* target, const std::string& config)
 {
   switch (target->GetType()) {
     case cmStateEnums::EXECUTABLE:
@@ -27,11 +28,11 @@ cmFastbuildTargetGenerator* cmFastbuildTargetGenerator::New(
     case cmStateEnums::STATIC_LIBRARY:
     case cmStateEnums::MODULE_LIBRARY:
     case cmStateEnums::OBJECT_LIBRARY:
-      return new cmFastbuildNormalTargetGenerator(target);
+      return new cmFastbuildNormalTargetGenerator(target, config);
 
     case cmStateEnums::UTILITY:
     case cmStateEnums::GLOBAL_TARGET:
-      return new cmFastbuildUtilityTargetGenerator(target);
+      return new cmFastbuildUtilityTargetGenerator(target, config);
 
     default:
       return nullptr;
@@ -39,12 +40,13 @@ cmFastbuildTargetGenerator* cmFastbuildTargetGenerator::New(
 }
 
 cmFastbuildTargetGenerator::cmFastbuildTargetGenerator(
-  cmGeneratorTarget* target)
+  cmGeneratorTarget* target, const std::string& config)
   : cmCommonTargetGenerator(target)
   , LocalGenerator(
       static_cast<cmLocalFastbuildGenerator*>(target->GetLocalGenerator()))
   , MacOSXContentGenerator(nullptr)
   , OSXBundleGenerator(nullptr)
+  , ConfigName(config)
 {
   MacOSXContentGenerator = new MacOSXContentGeneratorType(this);
 }
@@ -56,9 +58,23 @@ cmFastbuildTargetGenerator::~cmFastbuildTargetGenerator()
 
 std::string cmFastbuildTargetGenerator::GetConfigName()
 {
-  auto const& configNames = this->LocalGenerator->GetConfigNames();
-  assert(configNames.size() == 1);
-  return configNames.front();
+  return this->ConfigName;
+}
+
+std::string cmFastbuildTargetGenerator::BuildAlias(
+  const std::string& name) const
+{
+  return this->GetGlobalGenerator()->BuildAlias(name, this->ConfigName);
+}
+
+std::string cmFastbuildTargetGenerator::GetObjectDirectory() const
+{
+  std::string dir =
+    this->GeneratorTarget->GetObjectDirectory(this->ConfigName);
+  if (!dir.empty() && dir.back() == '/') {
+    dir.pop_back();
+  }
+  return dir;
 }
 
 void cmFastbuildTargetGenerator::MacOSXContentGeneratorType::operator()(
@@ -272,7 +288,7 @@ cmFastbuildTargetGenerator::GenerateCommands(const std::string& buildStep)
     if (!buildStep.empty()) {
       targetName = Makefile->GetCurrentBinaryDirectory();
       targetName += "/";
-      targetName += GeneratorTarget->GetName();
+      targetName += this->BuildAlias(GeneratorTarget->GetName());
       targetName = this->ConvertToFastbuildPath(targetName);
       targetName += "_" + buildStep + "_" + std::to_string(++i);
     }
@@ -283,7 +299,7 @@ cmFastbuildTargetGenerator::GenerateCommands(const std::string& buildStep)
     for (const std::string& dep : ccg.GetDepends()) {
       if (GlobalCommonGenerator->FindTarget(dep)) {
         // Keep as target name for now, we'll need to search for a target later
-        inputTargets.push_back(dep);
+        inputTargets.push_back(this->BuildAlias(dep));
       } else {
         // Try to convert file name to full path
         std::string realDep;
@@ -360,6 +376,18 @@ cmFastbuildTargetGenerator::GenerateCommands(const std::string& buildStep)
     execNode.Name = targetName;
     execNode.IsNoop = cmdLines.empty();
 
+    // Fastbuild has no depfile support: the command writes the dependencies
+    // it discovered to a fragment included in its Exec node, which must
+    // exist before the first build.
+    execNode.DepfileFragment = ccg.GetInternalDepfile();
+    if (!execNode.DepfileFragment.empty() &&
+        !cmSystemTools::FileExists(execNode.DepfileFragment) &&
+        !cmTransformDepfile(cmDepfileFormat::FastbuildExecInput,
+                            *this->LocalGenerator, ccg.GetFullDepfile(),
+                            execNode.DepfileFragment)) {
+      cmSystemTools::Error("Could not write " + execNode.DepfileFragment);
+    }
+
     std::vector<std::string> outputs;
     for (std::string const& output : ccg.GetOutputs()) {
       if (cmSourceFile* sf = this->Makefile->GetSource(output)) {
@@ -377,19 +405,9 @@ cmFastbuildTargetGenerator::GenerateCommands(const std::string& buildStep)
       }
     }
 
+    std::string scriptFileName;
     if (!execNode.IsNoop) {
-      std::string scriptFileName = Makefile->GetCurrentBinaryDirectory();
-      scriptFileName += "/CMakeFiles";
-      scriptFileName += "/";
-      scriptFileName += targetName;
-
-#ifdef _WIN32
-      scriptFileName += ".bat";
-#else
-      scriptFileName += ".sh";
-#endif
-
-      cmsys::ofstream scriptFile(scriptFileName.c_str());
+      std::ostringstream scriptFile;
 
 #ifdef _WIN32
       scriptFile << "@echo off\n";
@@ -400,9 +418,14 @@ cmFastbuildTargetGenerator::GenerateCommands(const std::string& buildStep)
       std::string output;
       if (outputs.size() == 1) {
         output = outputs[0];
+      } else if (!outputs.empty() &&
+                 GetGlobalGenerator()->SupportsExecOutputs()) {
+        output = outputs[0];
+        execNode.ExecOutputs =
+          GetGlobalGenerator()->ConvertToFastbuildPath(outputs);
       } else {
-        // Currently fastbuild doesn't support more than 1
-        // output for a custom command (soon to change hopefully).
+        // Older fastbuild versions don't support more than 1 output for a
+        // custom command, produce a stamp file instead.
         std::string outputDir =
           LocalCommonGenerator->GetMakefile()->GetHomeOutputDirectory();
         output = outputDir + "/dummy-out-" + targetName + ".txt";
@@ -441,6 +464,21 @@ cmFastbuildTargetGenerator::GenerateCommands(const std::string& buildStep)
                     "exit /b %ERROR_CODE%";
 #endif
 
+      // Only touch the script when it changes, so regenerating does not
+      // make the command run again.
+      scriptFileName =
+        cmStrCat(Makefile->GetCurrentBinaryDirectory(), "/CMakeFiles/",
+                 targetName,
+#ifdef _WIN32
+                 ".bat"
+#else
+                 ".sh"
+#endif
+        );
+      cmGeneratedFileStream scriptStream(scriptFileName);
+      scriptStream.SetCopyIfDifferent(true);
+      scriptStream << scriptFile.str();
+
 #ifdef _WIN32
       execNode.ExecExecutable = cmSystemTools::FindProgram("cmd.exe");
       execNode.ExecArguments = "/C " + scriptFileName;
@@ -465,6 +503,10 @@ cmFastbuildTargetGenerator::GenerateCommands(const std::string& buildStep)
     // Add files to input dependencies, after being converted to local path
     execNode.ExecInput =
       GetGlobalGenerator()->ConvertToFastbuildPath(inputFiles);
+    // The script is an input too, a change to it must re-run the command
+    if (!scriptFileName.empty()) {
+      execNode.ExecInput.push_back(ConvertToFastbuildPath(scriptFileName));
+    }
     // Also add targets to input dependencies
     for (auto const& target : inputTargets) {
       execNode.ExecInput.push_back(target);
@@ -505,25 +547,7 @@ cmFastbuildTargetGenerator::GenerateCommands(const std::string& buildStep)
       execNode.PreBuildDependencies.insert("noop");
     }
 
-    nodes.push_back(execNode);
-
-    if (outputs.size() > 1) {
-      for (const auto& output : outputs) {
-        cmGlobalFastbuildGenerator::FastbuildExecNode noop;
-        noop.Name = execNode.Name;
-        cmCryptoHash hash(cmCryptoHash::AlgoSHA256);
-        noop.Name += "-" + hash.HashString(output).substr(0, 7);
-        noop.PreBuildDependencies.insert(execNode.Name);
-        noop.ExecInput.push_back(execNode.ExecOutput);
-        noop.ExecOutput = ConvertToFastbuildPath(output);
-        std::string cmakeCommand =
-          this->GetLocalGenerator()->ConvertToOutputFormat(
-            cmSystemTools::GetCMakeCommand(), cmOutputConverter::SHELL);
-        noop.ExecExecutable = cmakeCommand;
-        noop.ExecArguments = " -E touch " + output;
-        noop.ExecWorkingDir = execNode.ExecWorkingDir;
-      }
-    }
+    nodes.push_back(std::move(execNode));
   }
 
   return nodes;
@@ -534,10 +558,21 @@ std::string cmFastbuildTargetGenerator::GetTargetName() const
   return this->GeneratorTarget->GetName();
 }
 
-void cmFastbuildTargetGenerator::AddIncludeFlags(std::string&,
-                                                 std::string const&,
-                                                 const std::string&)
+void cmFastbuildTargetGenerator::AddIncludeFlags(std::string& flags,
+                                                 std::string const& lang,
+                                                 const std::string& config)
 {
+  std::vector<std::string> includes;
+  this->LocalCommonGenerator->GetIncludeDirectories(
+    includes, this->GeneratorTarget, lang, config);
+
+  std::string includeFlags = this->LocalCommonGenerator->GetIncludeFlags(
+    includes, this->GeneratorTarget, lang, config, false,
+    // full include paths for RC needed by cmcldeps
+    lang == "RC" ? cmLocalGenerator::IncludePathStyle::Absolute
+                 : cmLocalGenerator::IncludePathStyle::Default);
+
+  this->LocalCommonGenerator->AppendFlags(flags, includeFlags);
 }
 
 std::string cmFastbuildTargetGenerator::GetName()
@@ -16,10 +16,13 @@ class cmLocalFastbuildGenerator;
 class cmFastbuildTargetGenerator : public cmCommonTargetGenerator
 {
 public:
-  /// Create a cmFastbuildTargetGenerator according to the @a target's type.
-  static cmFastbuildTargetGenerator* New(cmGeneratorTarget* target);
+  /// Create a cmFastbuildTargetGenerator according to the @a target's type,
+  /// generating its nodes for @a config.
+  static cmFastbuildTargetGenerator* New(cmGeneratorTarget* target,
+                                         const std::string& config);
 
-  cmFastbuildTargetGenerator(cmGeneratorTarget* target);
+  cmFastbuildTargetGenerator(cmGeneratorTarget* target,
+                             const std::string& config);
   ~cmFastbuildTargetGenerator() override;
 
   virtual void Generate() {}
@@ -47,6 +50,12 @@ public:
 
   std::string GetConfigName();
 
+  /// Name of the node building @a name in this configuration.
+  std::string BuildAlias(const std::string& name) const;
+
+  /// Directory of the object files of this configuration, no trailing '/'.
+  std::string GetObjectDirectory() const;
+
 protected:
   cmGeneratedFileStream& GetBuildFileStream() const
   {
@@ -100,6 +109,7 @@ protected:
 
 private:
   cmLocalFastbuildGenerator* LocalGenerator;
+  std::string ConfigName;
 
   typedef std::map<std::pair<const cmCustomCommand*, std::string>,
                    std::set<std::string>>
@@ -10,8 +10,8 @@
 #include "cmake.h"
 
 cmFastbuildUtilityTargetGenerator::cmFastbuildUtilityTargetGenerator(
-  cmGeneratorTarget* gt)
-  : cmFastbuildTargetGenerator(gt)
+  cmGeneratorTarget* gt, const std::string& config)
+  : cmFastbuildTargetGenerator(gt, config)
 {
 }
 
@@ -25,7 +25,9 @@ void cmFastbuildUtilityTargetGenerator::Generate()
   const std::string& configName = this->GetConfigName();
 
   cmGlobalFastbuildGenerator::FastbuildTarget fastbuildTarget;
-  fastbuildTarget.Name = targetName;
+  fastbuildTarget.Name = this->BuildAlias(targetName);
+  fastbuildTarget.Config = configName;
+  fastbuildTarget.GeneratorTarget = this->GeneratorTarget;
 
   // Get all dependencies
   cmTargetDependSet const& targetDeps =
@@ -36,9 +38,10 @@ void cmFastbuildUtilityTargetGenerator::Generate()
     } else if (depTarget->GetType() == cmStateEnums::GLOBAL_TARGET) {
       const cmGeneratorTarget& t = *depTarget;
       fastbuildTarget.Dependencies.push_back(
-        GetGlobalGenerator()->GetTargetName(&t));
+        this->BuildAlias(GetGlobalGenerator()->GetTargetName(&t)));
     } else {
-      fastbuildTarget.Dependencies.push_back(depTarget->GetName());
+      fastbuildTarget.Dependencies.push_back(
+        this->BuildAlias(depTarget->GetName()));
     }
   }
 
@@ -47,7 +50,8 @@ void cmFastbuildUtilityTargetGenerator::Generate()
       std::string d =
         GeneratorTarget->GetLocalGenerator()->GetCurrentBinaryDirectory() +
         "/" + util.Value.first;
-      fastbuildTarget.Dependencies.push_back(this->ConvertToFastbuildPath(d));
+      fastbuildTarget.Dependencies.push_back(
+        this->BuildAlias(this->ConvertToFastbuildPath(d)));
     }
   }
 
@@ -60,5 +64,5 @@ void cmFastbuildUtilityTargetGenerator::Generate()
   fastbuildTarget.IsExcluded =
     GetGlobalGenerator()->IsExcluded(GeneratorTarget);
 
-  GetLocalGenerator()->AddTarget(fastbuildTarget);
+  GetLocalGenerator()->AddTarget(std::move(fastbuildTarget));
 }
@@ -8,7 +8,8 @@
 class cmFastbuildUtilityTargetGenerator : public cmFastbuildTargetGenerator
 {
 public:
-  cmFastbuildUtilityTargetGenerator(cmGeneratorTarget* gt);
+  cmFastbuildUtilityTargetGenerator(cmGeneratorTarget* gt,
+                                    const std::string& config);
 
   virtual void Generate();
 };
@@ -15,6 +15,10 @@
 #include <algorithm>
 #include <future>
 #include <filesystem>
+#include <utility>
+
+#include <cm3p/json/value.h>
+#include <cm3p/json/writer.h>
 
 #ifdef _WIN32
 #  include <windows.h>
@@ -26,22 +30,31 @@
 #include "cmComputeLinkInformation.h"
 #include "cmCustomCommandGenerator.h"
 #include "cmDocumentationEntry.h"
+#include "cmFastbuildModules.h"
 #include "cmFastbuildNormalTargetGenerator.h"
 #include "cmFastbuildUtilityTargetGenerator.h"
 #include "cmGeneratedFileStream.h"
 #include "cmGeneratorTarget.h"
 #include "cmGlobalGeneratorFactory.h"
+#include "cmListFileCache.h"
 #include "cmLocalFastbuildGenerator.h"
 #include "cmLocalGenerator.h"
 #include "cmMakefile.h"
 #include "cmSourceFile.h"
 #include "cmState.h"
+#include "cmStringAlgorithms.h"
 #include "cmSystemTools.h"
 #include "cmTarget.h"
 #include "cmVersion.h"
 #include "cmake.h"
 
 const char* cmGlobalFastbuildGenerator::FASTBUILD_BUILD_FILE = "fbuild.bff";
+const char* cmGlobalFastbuildGenerator::FASTBUILD_FRAGMENTS_DIR =
+  "CMakeFiles/fbuild";
+const char* cmGlobalFastbuildGenerator::FASTBUILD_NODE_MAP_FILE =
+  "CMakeFiles/fbuild/nodes.json";
+const char* cmGlobalFastbuildGenerator::FASTBUILD_SCAN_FILE =
+  "CMakeFiles/fbuild/scan.bff";
 
 const char* cmGlobalFastbuildGenerator::INDENT = "  ";
 
@@ -90,6 +103,9 @@ bool cmGlobalFastbuildGenerator::FindMakeProgram(cmMakefile* mf)
     cmsys::RegularExpression versionRegex(R"(^FASTBuild v([0-9]+\.[0-9]+))");
     versionRegex.find(version);
     this->FastbuildVersion = versionRegex.match(1);
+    this->FastbuildExecOutputs = !cmSystemTools::VersionCompare(
+      cmSystemTools::OP_LESS, this->FastbuildVersion.c_str(),
+      ExecOutputsFastbuildVersion().c_str());
   }
   return true;
 }
@@ -127,25 +143,110 @@ cmGlobalFastbuildGenerator::GenerateBuildCommand(
   // makeCommand.Add("-quiet");
   makeCommand.Add("-monitor");
   makeCommand.Add("-ide");
-  makeCommand.Add("-cache");
   makeCommand.Add("-wait");
 
+  if (jobs != cmake::NO_BUILD_PARALLEL_LEVEL &&
+      jobs != cmake::DEFAULT_BUILD_PARALLEL_LEVEL) {
+    makeCommand.Add("-j" + std::to_string(jobs));
+  }
+  if (verbose) {
+    makeCommand.Add("-verbose");
+  }
+  // fbuild always brings the dependencies of a target up to date, there is
+  // no equivalent of the "fast" targets.
+  static_cast<void>(fast);
+
+  // Cache mode, ReadWrite unless asked otherwise. The short forms are the
+  // values fbuild itself accepts in FASTBUILD_CACHE_MODE.
+  std::string cacheMode = cmSystemTools::UpperCase(
+    this->GetBuildOption("CMAKE_FASTBUILD_CACHE_MODE"));
+  if (cacheMode.empty() || cacheMode == "READWRITE" || cacheMode == "RW") {
+    makeCommand.Add("-cache");
+  } else if (cacheMode == "READ" || cacheMode == "R") {
+    makeCommand.Add("-cacheread");
+  } else if (cacheMode == "WRITE" || cacheMode == "W") {
+    makeCommand.Add("-cachewrite");
+  } else if (!cmIsOff(cacheMode)) {
+    this->GetCMakeInstance()->IssueMessage(
+      MessageType::WARNING,
+      "CMAKE_FASTBUILD_CACHE_MODE has unknown value \"" + cacheMode +
+        "\", expected one of ReadWrite, Read, Write or Off.  "
+        "The cache is not used.");
+  }
+
+  if (cmIsOn(this->GetBuildOption("CMAKE_FASTBUILD_DISTRIBUTION"))) {
+    makeCommand.Add("-dist");
+  }
+  if (cmIsOn(this->GetBuildOption("CMAKE_FASTBUILD_NO_UNITY"))) {
+    makeCommand.Add("-nounity");
+  }
+
+  // Build report, ON or "html" for report.html, "json" for report.json.
+  std::string report =
+    cmSystemTools::LowerCase(this->GetBuildOption("CMAKE_FASTBUILD_REPORT"));
+  if (report == "json") {
+    makeCommand.Add("-report=json");
+  } else if (report == "html" || cmIsOn(report)) {
+    makeCommand.Add("-report");
+  }
+
   if (!configFile.empty()) {
     makeCommand.Add("-config", configFile);
   }
 
+  // Sources using modules are scanned by a first pass, fbuild reads the
+  // order it computes only when it parses the build files again.
+  std::vector<GeneratedMakeCommand> commands;
+  const std::string buildFileDir = configFile.empty()
+    ? projectDir
+    : cmSystemTools::GetFilenamePath(configFile);
+  const bool cleanOnly =
+    std::find(targetNames.begin(), targetNames.end(), "clean") !=
+      targetNames.end() &&
+    std::all_of(targetNames.begin(), targetNames.end(),
+                [](const std::string& tname) {
+                  return tname.empty() || tname == "clean";
+                });
+  if (!cleanOnly &&
+      cmSystemTools::FileExists(
+        cmStrCat(buildFileDir, '/', FASTBUILD_SCAN_FILE))) {
+    GeneratedMakeCommand scanCommand = makeCommand;
+    scanCommand.Add(this->BuildAlias("scan", config));
+    commands.push_back(std::move(scanCommand));
+  }
+
   // Add the target-config to the command
+  bool hasTarget = false;
   for (const auto& tname : targetNames) {
     if (!tname.empty()) {
       if (tname == "clean") {
         makeCommand.Add("-clean");
       } else {
-        makeCommand.Add(tname);
+        makeCommand.Add(this->BuildAlias(tname, config));
+        hasTarget = true;
       }
     }
   }
+  if (!hasTarget && this->IsMultiConfig() && !config.empty()) {
+    makeCommand.Add(this->BuildAlias("all", config));
+  }
 
-  return { std::move(makeCommand) };
+  commands.push_back(std::move(makeCommand));
+  return commands;
+}
+
+std::string cmGlobalFastbuildGenerator::GetBuildOption(
+  const std::string& name) const
+{
+  // The environment wins so a build can be tuned without reconfiguring.
+  std::string value;
+  if (cmSystemTools::GetEnv(name, value)) {
+    return value;
+  }
+  if (cmValue cached = this->GetCMakeInstance()->GetCacheDefinition(name)) {
+    value = *cached;
+  }
+  return value;
 }
 
 void cmGlobalFastbuildGenerator::ComputeTargetObjectDirectory(
@@ -157,6 +258,10 @@ void cmGlobalFastbuildGenerator::ComputeTargetObjectDirectory(
   dir += "/";
   dir += gt->LocalGenerator->GetTargetDirectory(gt);
   dir += "/";
+  if (this->IsMultiConfig()) {
+    dir += this->GetCMakeCFGIntDir();
+    dir += "/";
+  }
   gt->ObjectDirectory = dir;
 }
 
@@ -192,6 +297,14 @@ void cmGlobalFastbuildGenerator::Generate()
     return;
   }
 
+  // Read by GenerateBuildCommand when building, setting them with -D is
+  // not a mistake.
+  for (const char* option :
+       { "CMAKE_FASTBUILD_CACHE_MODE", "CMAKE_FASTBUILD_DISTRIBUTION",
+         "CMAKE_FASTBUILD_NO_UNITY", "CMAKE_FASTBUILD_REPORT" }) {
+    this->GetCMakeInstance()->MarkCliAsUsed(option);
+  }
+
   this->OpenBuildFileStream();
 
   this->WriteBuildFileTop(*this->BuildFileStream);
@@ -202,7 +315,9 @@ void cmGlobalFastbuildGenerator::Generate()
   // Write compilers
   this->WriteCompilers(*this->BuildFileStream);
 
-  this->WriteTargets(*this->BuildFileStream);
+  this->WriteTargets();
+
+  this->WriteNodeMap();
 
   if (cmSystemTools::GetErrorOccuredFlag()) {
     this->BuildFileStream->setstate(std::ios::failbit);
@@ -256,12 +371,46 @@ void cmGlobalFastbuildGenerator::WriteBuildFileTop(std::ostream& os)
 
   WriteCommand(os, "Settings");
   os << "{\n";
-  WriteArray(*this->BuildFileStream, "Environment",
-             Wrap(cmSystemTools::GetEnvironmentVariables()), 1);
-  WriteVariable(*this->BuildFileStream, "CachePath", Quote(cacheDir), 1);
+  WriteQuotedArray(os, "Environment", ComputeEnvironment(root->GetMakefile()),
+                   1);
+  WriteVariable(os, "CachePath", Quote(cacheDir), 1);
   os << "}\n";
 }
 
+std::vector<std::string> cmGlobalFastbuildGenerator::ComputeEnvironment(
+  cmMakefile* mf)
+{
+  // Only pass through the variables the toolchain needs, anything else in
+  // the developer's shell would change the bff and with it the Fastbuild
+  // cache keys. CMAKE_FASTBUILD_ENV_PASSTHROUGH extends this list.
+  std::vector<std::string> names = {
+    "PATH", "TMP", "TEMP", "TMPDIR",
+#ifdef _WIN32
+    "SystemRoot", "SystemDrive", "windir", "ComSpec", "PATHEXT",
+    "PROCESSOR_ARCHITECTURE", "INCLUDE", "LIB", "LIBPATH", "VSINSTALLDIR",
+    "VCINSTALLDIR", "VCToolsInstallDir", "VCToolsVersion", "WindowsSdkDir",
+    "WindowsSDKVersion", "WindowsSdkBinPath", "UniversalCRTSdkDir",
+    "UCRTVersion",
+#else
+    "LD_LIBRARY_PATH", "CPATH", "C_INCLUDE_PATH", "CPLUS_INCLUDE_PATH",
+    "LIBRARY_PATH", "SDKROOT", "DEVELOPER_DIR", "MACOSX_DEPLOYMENT_TARGET",
+#endif
+  };
+  cmExpandList(mf->GetSafeDefinition("CMAKE_FASTBUILD_ENV_PASSTHROUGH"),
+               names);
+  std::sort(names.begin(), names.end());
+  names.erase(std::unique(names.begin(), names.end()), names.end());
+
+  std::vector<std::string> environment;
+  for (const auto& name : names) {
+    std::string value;
+    if (cmSystemTools::GetEnv(name, value)) {
+      environment.push_back(name + "=" + value);
+    }
+  }
+  return environment;
+}
+
 void cmGlobalFastbuildGenerator::WriteDivider(std::ostream& os)
 {
   os << "// ======================================"
@@ -312,7 +461,7 @@ void cmGlobalFastbuildGenerator::WriteVariable(std::ostream& os,
                                                int indent)
 {
   cmGlobalFastbuildGenerator::Indent(os, indent);
-  os << "." << key << " " + op + " " << value << "\n";
+  os << '.' << key << ' ' << op << ' ' << value << '\n';
 }
 
 void cmGlobalFastbuildGenerator::WriteCommand(std::ostream& os,
@@ -358,56 +507,71 @@ void cmGlobalFastbuildGenerator::WriteArray(
   os << "}\n";
 }
 
-std::string cmGlobalFastbuildGenerator::Quote(const std::string& str,
-                                              const std::string& quotation)
+std::string cmGlobalFastbuildGenerator::Quote(cm::string_view str,
+                                              cm::string_view quotation)
 {
-  std::string result = str;
-  cmSystemTools::ReplaceString(result, quotation, "^" + quotation);
-  cmSystemTools::ReplaceString(result, FASTBUILD_DOLLAR_TAG, "$");
-  return quotation + result + quotation;
+  // Escape the quotation and turn the dollar tag back into '$' in one pass
+  static const cm::string_view tag = FASTBUILD_DOLLAR_TAG;
+  std::string result;
+  result.reserve(str.size() + 2 * quotation.size());
+  result.append(quotation.data(), quotation.size());
+  std::string::size_type pos = 0;
+  while (pos < str.size()) {
+    if (!quotation.empty() && str.substr(pos, quotation.size()) == quotation) {
+      result += '^';
+      result.append(quotation.data(), quotation.size());
+      pos += quotation.size();
+    } else if (str[pos] == tag[0] && str.substr(pos, tag.size()) == tag) {
+      result += '$';
+      pos += tag.size();
+    } else {
+      result += str[pos++];
+    }
+  }
+  result.append(quotation.data(), quotation.size());
+  return result;
 }
 
-struct WrapHelper
+void cmGlobalFastbuildGenerator::WriteQuoted(std::ostream& os,
+                                             cm::string_view value,
+                                             bool escapeDollar)
 {
-  std::string m_prefix;
-  std::string m_suffix;
-  bool escape_dollar;
-
-  std::string operator()(const std::string& in)
-  {
-    std::string result = m_prefix + in + m_suffix;
-    if (escape_dollar) {
-      cmSystemTools::ReplaceString(result, "$", "^$");
-      cmSystemTools::ReplaceString(result, FASTBUILD_DOLLAR_TAG, "$");
+  os << '\'';
+  if (!escapeDollar) {
+    os << value;
+  } else {
+    // Escape '$' and turn the dollar tag back into '$' in one pass
+    static const cm::string_view tag = FASTBUILD_DOLLAR_TAG;
+    std::string::size_type begin = 0;
+    std::string::size_type pos = 0;
+    while (pos < value.size()) {
+      if (value[pos] == '$') {
+        os << value.substr(begin, pos - begin) << "^$";
+        begin = ++pos;
+      } else if (value[pos] == tag[0] &&
+                 value.substr(pos, tag.size()) == tag) {
+        os << value.substr(begin, pos - begin) << '$';
+        begin = pos += tag.size();
+      } else {
+        ++pos;
+      }
     }
-    return result;
+    os << value.substr(begin);
   }
-};
+  os << '\'';
+}
 
-std::vector<std::string> cmGlobalFastbuildGenerator::Wrap(
-  const std::vector<std::string>& in, const std::string& prefix,
-  const std::string& suffix, const bool escape_dollar)
+void cmGlobalFastbuildGenerator::WriteStructBegin(std::ostream& os,
+                                                  const std::string& key,
+                                                  int indent)
 {
-  std::vector<std::string> result;
-
-  WrapHelper helper = { prefix, suffix, escape_dollar };
-
-  std::transform(in.begin(), in.end(), std::back_inserter(result), helper);
-
-  return result;
+  WriteVariable(os, key, "[", indent);
 }
 
-std::vector<std::string> cmGlobalFastbuildGenerator::Wrap(
-  const std::set<std::string>& in, const std::string& prefix,
-  const std::string& suffix, const bool escape_dollar)
+void cmGlobalFastbuildGenerator::WriteStructEnd(std::ostream& os, int indent)
 {
-  std::vector<std::string> result;
-
-  WrapHelper helper = { prefix, suffix, escape_dollar };
-
-  std::transform(in.begin(), in.end(), std::back_inserter(result), helper);
-
-  return result;
+  Indent(os, indent);
+  os << "]\n";
 }
 
 void cmGlobalFastbuildGenerator::WriteDisclaimer(std::ostream& os)
@@ -435,6 +599,7 @@ void cmGlobalFastbuildGenerator::OpenBuildFileStream()
       // open the file.
       return;
     }
+    this->BuildFileStream->SetCopyIfDifferent(true);
   }
 
   // Write the do not edit header.
@@ -455,12 +620,13 @@ void cmGlobalFastbuildGenerator::CloseBuildFileStream()
   }
 }
 
-void cmGlobalFastbuildGenerator::AddTarget(const FastbuildTarget& target)
+void cmGlobalFastbuildGenerator::AddTarget(FastbuildTarget&& target)
 {
-  if (FastbuildTargets.find(target.Name) != FastbuildTargets.end()) {
+  auto& entry = FastbuildTargets[target.Name];
+  if (!entry.Name.empty()) {
     cmSystemTools::Error("Duplicated target " + target.Name);
   }
-  FastbuildTargets[target.Name] = target;
+  entry = std::move(target);
 }
 
 void cmGlobalFastbuildGenerator::WriteCompilers(std::ostream& os)
@@ -504,8 +670,7 @@ void cmGlobalFastbuildGenerator::WriteCompilers(std::ostream& os)
       // Do not escape '$' sign, CMAKE_${LANG}_FASTBUILD_EXTRA_FILES might
       // contain FB variables to be expanded (we do use some internaly).
       // Besides a path cannot contain a '$'
-      WriteArray(os, "ExtraFiles",
-                 Wrap(compilerDef.extraFiles, "'", "'", false), 1);
+      WriteQuotedArray(os, "ExtraFiles", compilerDef.extraFiles, 1, false);
     os << "}\n";
 
     auto compilerId = compilerDef.name;
@@ -519,6 +684,80 @@ void cmGlobalFastbuildGenerator::WriteCompilers(std::ostream& os)
                   Quote(this->Compilers.begin()->second.name));
 }
 
+namespace {
+// Ask a GCC or Clang driver for the programs and files it loads besides
+// itself, so that the Compiler node describes a self-contained toolchain
+// (see https://fastbuild.org/docs/functions/compiler.html).
+std::vector<std::string> DiscoverToolchainFiles(const std::string& compiler,
+                                                const std::string& language,
+                                                const std::string& compilerId)
+{
+  auto query = [&compiler](const std::string& arg) -> std::string {
+    std::string output;
+    int retVal = 0;
+    if (!cmSystemTools::RunSingleCommand({ compiler, arg }, &output, nullptr,
+                                         &retVal, nullptr,
+                                         cmSystemTools::OUTPUT_NONE) ||
+        retVal != 0) {
+      return std::string();
+    }
+    return cmTrimWhitespace(output);
+  };
+
+  std::vector<std::string> files;
+  // Drivers echo the bare name back when they do not know the file.
+  auto addFile = [&files](std::string file) {
+    if (cmSystemTools::FileIsFullPath(file) &&
+        cmSystemTools::FileExists(file, true)) {
+      files.push_back(cmSystemTools::CollapseFullPath(file));
+    }
+  };
+
+  // Programs the driver does not ship itself are looked up in the PATH.
+  auto addProgram = [&](const std::string& name) {
+    std::string program = query("-print-prog-name=" + name);
+    if (program == name) {
+      program = cmSystemTools::FindProgram(name);
+    }
+    addFile(program);
+  };
+
+  if (compilerId == "GNU") {
+    // The backend compiling each language, others are not known.
+    static std::map<std::string, std::string> const backends = {
+      { "C", "cc1" },          { "CXX", "cc1plus" },
+      { "OBJC", "cc1obj" },    { "OBJCXX", "cc1objplus" },
+      { "Fortran", "f951" },
+    };
+    auto backend = backends.find(language);
+    if (backend == backends.end()) {
+      return files;
+    }
+    addProgram(backend->second);
+    addProgram("as");
+    addProgram("collect2");
+    addFile(query("-print-file-name=liblto_plugin.so"));
+  } else if (compilerId == "Clang" || compilerId == "AppleClang") {
+    std::string includeDir = query("-print-resource-dir") + "/include";
+    if (cmSystemTools::FileIsFullPath(includeDir) &&
+        cmSystemTools::FileIsDirectory(includeDir)) {
+      std::error_code ec;
+      for (auto const& entry :
+           std::filesystem::recursive_directory_iterator{ includeDir, ec }) {
+        if (entry.is_regular_file()) {
+          files.push_back(entry.path().generic_string());
+        }
+      }
+      // Directory iteration order is unspecified, keep the bff stable.
+      std::sort(files.begin(), files.end());
+    }
+  }
+
+  files.erase(std::unique(files.begin(), files.end()), files.end());
+  return files;
+}
+}
+
 void cmGlobalFastbuildGenerator::AddCompiler(const std::string& language,
                                              cmMakefile* mf)
 {
@@ -568,7 +807,8 @@ void cmGlobalFastbuildGenerator::AddCompiler(const std::string& language,
 
   // Automatically add extra files based on compiler (see
   // https://fastbuild.org/docs/functions/compiler.html)
-  if (language == "C" || language == "CXX") {
+  if (language == "C" || language == "CXX" || language == "OBJC" ||
+      language == "OBJCXX" || language == "Fortran") {
     if (compilerDef.cmakeCompilerID == "MSVC") {
       // https://cmake.org/cmake/help/latest/variable/MSVC_VERSION.html
 
@@ -622,6 +862,47 @@ void cmGlobalFastbuildGenerator::AddCompiler(const std::string& language,
         compilerDef.extraFiles.push_back("$Root$/" + i18nNum + "/clui.dll");
       }
     }
+    // GCC and Clang (but not clang-cl) can tell which files they need.
+    else if (mf->GetSafeDefinition("CMAKE_" + language +
+                                   "_COMPILER_FRONTEND_VARIANT") != "MSVC") {
+      // Querying the driver costs a few processes per language, remember
+      // the answer for the compiler it was computed for.  An upgrade in
+      // place keeps the path, so the size and time of the file are part
+      // of the key.
+      std::string const cacheKey =
+        "CMAKE_" + language + "_FASTBUILD_TOOLCHAIN_FILES";
+      std::string const cacheCompilerKey = cacheKey + "_COMPILER";
+      std::string const compilerKey = cmStrCat(
+        compilerLocation, ';', compilerDef.cmakeCompilerVersion, ';',
+        cmSystemTools::FileLength(compilerLocation), ';',
+        cmSystemTools::ModifiedTime(compilerLocation));
+      cmState* state = this->GetCMakeInstance()->GetState();
+      cmValue cachedFiles = state->GetCacheEntryValue(cacheKey);
+      cmValue cachedCompiler = state->GetCacheEntryValue(cacheCompilerKey);
+      std::vector<std::string> toolchainFiles;
+      if (cachedFiles && cachedCompiler && *cachedCompiler == compilerKey) {
+        toolchainFiles = cmExpandedList(*cachedFiles);
+      } else {
+        toolchainFiles = DiscoverToolchainFiles(
+          compilerLocation, language, compilerDef.cmakeCompilerID);
+        this->GetCMakeInstance()->AddCacheEntry(
+          cacheKey, cmJoin(toolchainFiles, ";"),
+          "Files used by the compiler, listed as FASTBuild ExtraFiles.",
+          cmStateEnums::INTERNAL);
+        this->GetCMakeInstance()->AddCacheEntry(
+          cacheCompilerKey, compilerKey,
+          "Path, version, size and time of the compiler the FASTBuild "
+          "ExtraFiles were discovered for.",
+          cmStateEnums::INTERNAL);
+      }
+      for (std::string& file : toolchainFiles) {
+        if (std::find(compilerDef.extraFiles.begin(),
+                      compilerDef.extraFiles.end(),
+                      file) == compilerDef.extraFiles.end()) {
+          compilerDef.extraFiles.push_back(std::move(file));
+        }
+      }
+    }
     // TODO: Handle Intel compiler
   }
 
@@ -702,8 +983,8 @@ std::set<std::string> cmGlobalFastbuildGenerator::WriteExecs(
       *BuildFileStream << "{\n";
       {
         if (!Exec.PreBuildDependencies.empty()) {
-          WriteArray(*BuildFileStream, "PreBuildDependencies",
-                     Wrap(Exec.PreBuildDependencies), 2);
+          WriteQuotedArray(*BuildFileStream, "PreBuildDependencies",
+                           Exec.PreBuildDependencies, 2);
         }
         WriteVariable(*BuildFileStream, "ExecExecutable",
                       Quote(Exec.ExecExecutable), 2);
@@ -716,17 +997,27 @@ std::set<std::string> cmGlobalFastbuildGenerator::WriteExecs(
                         Quote(Exec.ExecWorkingDir), 2);
         }
         if (!execInput.empty()) {
-          WriteArray(*BuildFileStream, "ExecInput", Wrap(execInput), 2);
+          WriteQuotedArray(*BuildFileStream, "ExecInput", execInput, 2);
         }
         if (Exec.ExecUseStdOutAsOutput) {
           WriteVariable(*BuildFileStream, "ExecUseStdOutAsOutput", "true", 2);
         }
         WriteVariable(*BuildFileStream, "ExecAlwaysShowOutput", "true", 2);
-        WriteVariable(*BuildFileStream, "ExecOutput", Quote(Exec.ExecOutput),
-                      2);
+        if (Exec.ExecOutputs.empty()) {
+          WriteVariable(*BuildFileStream, "ExecOutput",
+                        Quote(Exec.ExecOutput), 2);
+        } else {
+          WriteQuotedArray(*BuildFileStream, "ExecOutputs", Exec.ExecOutputs,
+                           2);
+        }
         if (execAlways) {
           WriteVariable(*BuildFileStream, "ExecAlways", "true", 2);
         }
+        if (!Exec.DepfileFragment.empty()) {
+          Indent(*BuildFileStream, 2);
+          *BuildFileStream << "#include \"" << Exec.DepfileFragment
+                           << "\"\n";
+        }
       }
       Indent(*BuildFileStream, 1);
       *BuildFileStream << "}\n";
@@ -740,6 +1031,51 @@ std::set<std::string> cmGlobalFastbuildGenerator::WriteExecs(
   return output;
 }
 
+std::set<std::string> cmGlobalFastbuildGenerator::WriteUnity(
+  const std::vector<FastbuildUnityNode>& UnityNodes,
+  const std::set<std::string>& dependencies)
+{
+  std::set<std::string> output;
+
+  for (const auto& Unity : UnityNodes) {
+    output.insert(Unity.Name);
+
+    WriteCommand(*BuildFileStream, "Unity", Quote(Unity.Name), 1);
+    Indent(*BuildFileStream, 1);
+    *BuildFileStream << "{\n";
+    {
+      if (!dependencies.empty())
+        WriteQuotedArray(*BuildFileStream, "PreBuildDependencies",
+                         dependencies, 2);
+      WriteQuotedArray(*BuildFileStream, "UnityInputFiles",
+                       Unity.UnityInputFiles, 2);
+      WriteVariable(*BuildFileStream, "UnityOutputPath",
+                    Quote(Unity.UnityOutputPath), 2);
+      WriteVariable(*BuildFileStream, "UnityOutputPattern",
+                    Quote(Unity.UnityOutputPattern), 2);
+      WriteVariable(*BuildFileStream, "UnityNumFiles",
+                    std::to_string(Unity.UnityNumFiles), 2);
+      if (Unity.UnityInputIsolateWritableFiles) {
+        WriteVariable(*BuildFileStream, "UnityInputIsolateWritableFiles",
+                      "true", 2);
+        if (Unity.UnityInputIsolateWritableFilesLimit > 0) {
+          WriteVariable(
+            *BuildFileStream, "UnityInputIsolateWritableFilesLimit",
+            std::to_string(Unity.UnityInputIsolateWritableFilesLimit), 2);
+        }
+      }
+      if (!Unity.UnityInputIsolateListFile.empty()) {
+        WriteVariable(*BuildFileStream, "UnityInputIsolateListFile",
+                      Quote(Unity.UnityInputIsolateListFile), 2);
+      }
+    }
+    Indent(*BuildFileStream, 1);
+    *BuildFileStream << "}\n";
+  }
+
+  return output;
+}
+
 std::set<std::string> cmGlobalFastbuildGenerator::WriteObjectLists(
   const std::vector<FastbuildObjectListNode>& ObjectLists,
   const std::set<std::string>& dependencies)
@@ -749,16 +1085,23 @@ std::set<std::string> cmGlobalFastbuildGenerator::WriteObjectLists(
   for (const auto& ObjectList : ObjectLists) {
     output.insert(ObjectList.Name);
 
-    WriteCommand(*BuildFileStream, "ObjectList", Quote(ObjectList.Name), 1);
-    Indent(*BuildFileStream, 1);
-    *BuildFileStream << "{\n";
+    // The module fragment adds the dependencies on the modules used.
+    if (ObjectList.ScanModules) {
+      WriteStructBegin(*BuildFileStream,
+                       cmFastbuildModules::StructName(ObjectList.Name), 1);
+    } else {
+      WriteCommand(*BuildFileStream, "ObjectList", Quote(ObjectList.Name),
+                   1);
+      Indent(*BuildFileStream, 1);
+      *BuildFileStream << "{\n";
+    }
     {
       std::set<std::string> objectListDependencies = dependencies;
       for (const auto& dependency : ObjectList.PreBuildDependencies)
         objectListDependencies.insert(dependency);
-      if (!objectListDependencies.empty())
-        WriteArray(*BuildFileStream, "PreBuildDependencies",
-                   Wrap(objectListDependencies), 2);
+      if (!objectListDependencies.empty() || ObjectList.ScanModules)
+        WriteQuotedArray(*BuildFileStream, "PreBuildDependencies",
+                         objectListDependencies, 2);
       WriteVariable(*BuildFileStream, "Compiler", ObjectList.Compiler, 2);
       WriteVariable(*BuildFileStream, "CompilerOptions",
                     Quote(ObjectList.CompilerOptions), 2);
@@ -768,8 +1111,18 @@ std::set<std::string> cmGlobalFastbuildGenerator::WriteObjectLists(
                     Quote(ObjectList.CompilerOutputExtension), 2);
       WriteVariable(*BuildFileStream, "CompilerOutputKeepBaseExtension",
                     "true", 2);
-      WriteArray(*BuildFileStream, "CompilerInputFiles",
-                 Wrap(ObjectList.CompilerInputFiles), 2);
+      if (!ObjectList.CompilerInputUnity.empty()) {
+        WriteVariable(*BuildFileStream, "CompilerInputUnity",
+                      Quote(ObjectList.CompilerInputUnity), 2);
+      }
+      if (!ObjectList.CompilerInputFiles.empty()) {
+        WriteQuotedArray(*BuildFileStream, "CompilerInputFiles",
+                         ObjectList.CompilerInputFiles, 2);
+      }
+      if (!ObjectList.CompilerInputFilesRoot.empty()) {
+        WriteVariable(*BuildFileStream, "CompilerInputFilesRoot",
+                      Quote(ObjectList.CompilerInputFilesRoot), 2);
+      }
       if (!ObjectList.PCHInputFile.empty()) {
         WriteVariable(*BuildFileStream, "PCHInputFile",
                       Quote(ObjectList.PCHInputFile), 2);
@@ -780,9 +1133,19 @@ std::set<std::string> cmGlobalFastbuildGenerator::WriteObjectLists(
         WriteVariable(*BuildFileStream, "PCHOutputFile",
                       Quote(ObjectList.PCHOutputFile), 2);
       }
+      if (!ObjectList.AllowCaching) {
+        WriteVariable(*BuildFileStream, "AllowCaching", "false", 2);
+      }
+      if (!ObjectList.AllowDistribution) {
+        WriteVariable(*BuildFileStream, "AllowDistribution", "false", 2);
+      }
+    }
+    if (ObjectList.ScanModules) {
+      WriteStructEnd(*BuildFileStream, 1);
+    } else {
+      Indent(*BuildFileStream, 1);
+      *BuildFileStream << "}\n";
     }
-    Indent(*BuildFileStream, 1);
-    *BuildFileStream << "}\n";
   }
 
   return output;
@@ -816,16 +1179,16 @@ std::set<std::string> cmGlobalFastbuildGenerator::WriteLinker(
       *BuildFileStream << "{\n";
       {
         if (!PreBuildDependencies.empty())
-          WriteArray(*BuildFileStream, "PreBuildDependencies",
-                     Wrap(PreBuildDependencies), 2);
+          WriteQuotedArray(*BuildFileStream, "PreBuildDependencies",
+                           PreBuildDependencies, 2);
         WriteVariable(*BuildFileStream, "Linker", Quote(LinkerNode.Linker), 2);
         WriteVariable(*BuildFileStream, "LinkerOptions",
                       Quote(LinkerNode.LinkerOptions), 2);
         WriteVariable(*BuildFileStream, "LinkerOutput",
                       Quote(LinkerNode.LinkerOutput), 2);
         WriteVariable(*BuildFileStream, "LinkerAllowResponseFile", "true", 2);
-        WriteArray(*BuildFileStream, "Libraries", Wrap(LinkerNode.Libraries),
-                   2);
+        WriteQuotedArray(*BuildFileStream, "Libraries", LinkerNode.Libraries,
+                         2);
         WriteVariable(*BuildFileStream, "LinkerLinkObjects", "false", 2);
         WriteVariable(*BuildFileStream, "LinkerType",
                       Quote(LinkerNode.LinkerType), 2);
@@ -838,14 +1201,14 @@ std::set<std::string> cmGlobalFastbuildGenerator::WriteLinker(
       *BuildFileStream << "{\n";
       {
         if (!PreBuildDependencies.empty())
-          WriteArray(*BuildFileStream, "PreBuildDependencies",
-                     Wrap(PreBuildDependencies), 2);
+          WriteQuotedArray(*BuildFileStream, "PreBuildDependencies",
+                           PreBuildDependencies, 2);
         WriteVariable(*BuildFileStream, "Librarian", Quote(LinkerNode.Linker),
                       2);
         WriteVariable(*BuildFileStream, "LibrarianOptions",
                       Quote(LinkerNode.LinkerOptions), 2);
-        WriteArray(*BuildFileStream, "LibrarianAdditionalInputs",
-                   Wrap(LinkerNode.Libraries), 2);
+        WriteQuotedArray(*BuildFileStream, "LibrarianAdditionalInputs",
+                         LinkerNode.Libraries, 2);
         WriteVariable(*BuildFileStream, "LibrarianOutput",
                       Quote(LinkerNode.LinkerOutput), 2);
         WriteVariable(*BuildFileStream, "LibrarianAllowResponseFile", "true", 2);
@@ -872,7 +1235,7 @@ void cmGlobalFastbuildGenerator::WriteAlias(
   WriteCommand(*BuildFileStream, "Alias", Quote(alias), 1);
   Indent(*BuildFileStream, 1);
   *BuildFileStream << "{\n";
-  WriteArray(*BuildFileStream, "Targets", Wrap(targets), 2);
+  WriteQuotedArray(*BuildFileStream, "Targets", targets, 2);
   Indent(*BuildFileStream, 1);
   *BuildFileStream << "}\n";
 }
@@ -885,24 +1248,37 @@ void cmGlobalFastbuildGenerator::WriteAlias(
   WriteCommand(*BuildFileStream, "Alias", Quote(alias), 1);
   Indent(*BuildFileStream, 1);
   *BuildFileStream << "{\n";
-  WriteArray(*BuildFileStream, "Targets", Wrap(targets), 2);
+  WriteQuotedArray(*BuildFileStream, "Targets", targets, 2);
   Indent(*BuildFileStream, 1);
   *BuildFileStream << "}\n";
 }
 
-void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
+void cmGlobalFastbuildGenerator::WriteTargets()
 {
+  const std::vector<std::string>& configs =
+    static_cast<cmLocalCommonGenerator*>(this->LocalGenerators[0].get())
+      ->GetConfigNames();
+
   // Add "all" and "noop" targets
   {
-    FastbuildTarget allTarget;
-    FastbuildAliasNode allNode;
+    // One "all" per configuration
+    std::map<std::string, FastbuildTarget> allTargets;
+    for (const auto& config : configs) {
+      FastbuildTarget& allTarget = allTargets[config];
+      allTarget.Name = this->BuildAlias("all", config);
+      allTarget.Config = config;
+      allTarget.IsGlobal = true;
+      allTarget.AliasNodes.emplace_back().Name = allTarget.Name;
+    }
 
     // Some pre-processing on Targets
     for (auto& it : FastbuildTargets) {
       auto& Target = it.second;
       // Add non-global and non-excluded targets to "all"
       if (!Target.IsGlobal && !Target.IsExcluded) {
-        allNode.Targets.insert(Target.Name + "-products");
+        FastbuildTarget& allTarget = allTargets.at(Target.Config);
+        allTarget.AliasNodes.front().Targets.insert(Target.Name +
+                                                    "-products");
         allTarget.Dependencies.push_back(Target.Name);
       }
       // Search for ExecNodes that depend on Noop and add this dependency to
@@ -938,19 +1314,23 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
 
       FastbuildTargets[noop.Name] = noop;
 
-      if (allNode.Targets.empty()) {
-        allNode.Targets.insert(noop.Name + "-products");
-        allTarget.Dependencies.push_back(noop.Name);
+      for (auto& [_, allTarget] : allTargets) {
+        if (allTarget.AliasNodes.front().Targets.empty()) {
+          allTarget.AliasNodes.front().Targets.insert(noop.Name +
+                                                      "-products");
+          allTarget.Dependencies.push_back(noop.Name);
+        }
       }
     }
 
     // "all" target
-    {
-      allTarget.Name = allNode.Name = "all";
-      allTarget.AliasNodes.push_back(allNode);
-      allTarget.IsGlobal = true;
-
+    for (auto& [config, allTarget] : allTargets) {
 #ifdef _WIN32
+      if (!this->DefaultFileConfig.empty() &&
+          config != this->DefaultFileConfig) {
+        FastbuildTargets[allTarget.Name] = std::move(allTarget);
+        continue;
+      }
       auto& VCXProject = allTarget.VCXProjects.emplace_back();
       std::string targetName = "ALL_BUILD";
 
@@ -961,10 +1341,7 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
       VCXProject.ProjectOutput = ConvertToFastbuildPath(
         targetCompileOutDirectory + "/" + targetName + ".vcxproj");
       VCXProject.Platform = "X64";
-      VCXProject.Config =
-        ((cmLocalCommonGenerator*)this->LocalGenerators[0].get())
-          ->GetConfigNames()
-          .front();
+      VCXProject.Config = config;
       VCXProject.Target = "all";
       VCXProject.Folder = "CMakePredefinedTargets";
 
@@ -979,11 +1356,39 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
         cmStrCat(VCXProject.ProjectBuildCommand, " -- -clean");
 #endif
 
-      FastbuildTargets[allTarget.Name] = allTarget;
+      FastbuildTargets[allTarget.Name] = std::move(allTarget);
+    }
+  }
+
+  // With several configurations the plain names build the default one
+  if (!this->DefaultFileConfig.empty()) {
+    const std::string suffix = this->BuildAlias("", this->DefaultFileConfig);
+    std::vector<FastbuildTarget> defaultTargets;
+    for (const auto& [Name, Target] : FastbuildTargets) {
+      if (Target.Config != this->DefaultFileConfig ||
+          !cmHasSuffix(Name, suffix)) {
+        continue;
+      }
+      FastbuildTarget defaultTarget;
+      defaultTarget.Name = Name.substr(0, Name.size() - suffix.size());
+      if (FastbuildTargets.count(defaultTarget.Name)) {
+        continue;
+      }
+      defaultTarget.IsGlobal = true;
+      defaultTarget.Dependencies.push_back(Name);
+      defaultTarget.AliasNodes.push_back({ defaultTarget.Name, { Name } });
+      defaultTargets.push_back(std::move(defaultTarget));
+    }
+    for (auto& defaultTarget : defaultTargets) {
+      std::string name = defaultTarget.Name;
+      FastbuildTargets.emplace(std::move(name), std::move(defaultTarget));
     }
   }
 
-  // Add "rebuild-bff" target
+  // Add "rebuild-bff" target.  It configures and generates the whole
+  // project again when any list file changes: CMake cannot regenerate one
+  // target alone.  Only the fragments whose content changed are rewritten,
+  // so fbuild sees the others unchanged.
   {
     std::vector<std::string> implicitDeps;
     for (auto& lg : LocalGenerators) {
@@ -1058,19 +1463,48 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
         }
       }
 
-      if (!node.ObjectDependencies.empty()) {
+      // Remaining dependencies are plain files. One node per ObjectList
+      // removes its objects when they change so Fastbuild compiles them
+      // again, the sources themselves are left untouched.
+      if (!node.ObjectDependencies.empty() &&
+          !node.CompilerInputFiles.empty()) {
+        FastbuildExecNode execNode;
+        execNode.Name = "object-dependencies-";
+        cmCryptoHash hash(cmCryptoHash::AlgoSHA256);
+        execNode.Name += hash.HashString(node.Name).substr(0, 7);
+        execNode.ExecExecutable = cmSystemTools::GetCMakeCommand();
+        execNode.ExecArguments = "-E rm -f";
+        std::string outputPath = node.CompilerOutputPath;
+        if (outputPath.back() != '/') {
+          outputPath += '/';
+        }
+        // Objects keep the layout below CompilerInputFilesRoot if set.
+        std::string const binaryDir =
+          this->GetCMakeInstance()->GetHomeOutputDirectory();
+        std::string inputRoot;
+        if (!node.CompilerInputFilesRoot.empty()) {
+          inputRoot = cmStrCat(
+            cmSystemTools::CollapseFullPath(node.CompilerInputFilesRoot,
+                                            binaryDir),
+            '/');
+        }
         for (const auto& inputFile : node.CompilerInputFiles) {
-          FastbuildExecNode execNode;
-          execNode.Name = "object-dependencies-";
-          cmCryptoHash hash(cmCryptoHash::AlgoSHA256);
-          execNode.Name += hash.HashString(inputFile + node.Name).substr(0, 7);
-          execNode.ExecExecutable = cmSystemTools::GetCMakeCommand();
-          execNode.ExecArguments = "-E touch " + inputFile;
-          execNode.ExecInput = node.ObjectDependencies;
-          execNode.ExecOutput = "dummy-" + execNode.Name + ".txt";
-          execNode.ExecUseStdOutAsOutput = true;
-          Target.ExecNodes.push_back(execNode);
+          std::string objectName = cmSystemTools::GetFilenameName(inputFile);
+          if (!inputRoot.empty()) {
+            std::string fullInput =
+              cmSystemTools::CollapseFullPath(inputFile, binaryDir);
+            if (cmHasPrefix(fullInput, inputRoot)) {
+              objectName = fullInput.substr(inputRoot.size());
+            }
+          }
+          execNode.ExecArguments += cmStrCat(' ', outputPath, objectName,
+                                             node.CompilerOutputExtension);
         }
+        execNode.ExecInput = node.ObjectDependencies;
+        execNode.ExecOutput = "dummy-" + execNode.Name + ".txt";
+        execNode.ExecUseStdOutAsOutput = true;
+        node.PreBuildDependencies.insert(execNode.Name);
+        Target.ExecNodes.push_back(std::move(execNode));
       }
     }
   }
@@ -1078,68 +1512,44 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
   // Sort targets by dependencies, Fastbuild doesn't like it any other way
   std::vector<std::string> orderedTargets;
   {
-    std::vector<std::string> targets;
-    std::unordered_multimap<std::string, std::string> forwardDependencies,
-      reverseDependencies;
-    // Create forward and reverse dependencies maps
-    for (const auto& it : FastbuildTargets) {
-      const auto& Target = it.second;
-
-      targets.push_back(Target.Name);
+    std::unordered_multimap<std::string, std::string> dependencies;
+    for (const auto& [Name, Target] : FastbuildTargets) {
+      orderedTargets.push_back(Name);
       for (const auto& Dependency : Target.Dependencies) {
-        forwardDependencies.emplace(Target.Name, Dependency);
-        reverseDependencies.emplace(Dependency, Target.Name);
+        dependencies.emplace(Name, Dependency);
       }
     }
 
-    // Sort targets by dependencies
-    // (ie. add to the list only if it doesn't depend on anything)
-    while (!targets.empty()) {
-      size_t initialSize = targets.size();
-      for (auto it = targets.begin(); it != targets.end();) {
-        auto targetName = *it;
-        if (forwardDependencies.find(targetName) ==
-            forwardDependencies.end()) {
-          orderedTargets.emplace_back(targetName);
-          it = targets.erase(it);
-
-          auto range = reverseDependencies.equal_range(targetName);
-          for (auto rt = range.first; rt != range.second; ++rt) {
-            // Fetch the list of deps on that target
-            auto frange = forwardDependencies.equal_range(rt->second);
-            for (auto ft = frange.first; ft != frange.second;) {
-              if (ft->second == targetName) {
-                ft = forwardDependencies.erase(ft);
-              } else {
-                ++ft;
-              }
-            }
-          }
-        } else {
-          ++it;
-        }
-      }
-      if (initialSize == targets.size()) {
-        for (const auto& target : targets) {
-          orderedTargets.push_back(target);
-        }
-        targets.clear();
-      }
+    auto cycle = SortByDependencies(orderedTargets, dependencies);
+    if (!cycle.empty()) {
+      this->GetCMakeInstance()->IssueMessage(
+        MessageType::FATAL_ERROR,
+        cmStrCat("The Fastbuild targets depend on each other in a cycle:\n  ",
+                 cmJoin(cycle, "\n  ")));
     }
   }
 
-  // Reuse precompiled headers whenever possible
-  std::set<std::string> pch;
+  // Build every precompiled header once, in the first object list asking
+  // for it. The others, in the same target or in targets using
+  // PRECOMPILE_HEADERS_REUSE_FROM, wait for that object list instead.
+  std::map<std::string, std::string> pch;
   for (const auto& targetName : orderedTargets) {
     auto& Target = FastbuildTargets[targetName];
 
     for (auto& objNode : Target.ObjectListNodes) {
-      if (pch.count(objNode.PCHOutputFile)) {
-        objNode.PCHInputFile.clear();
-        objNode.PCHOptions.clear();
-      } else {
-        pch.insert(objNode.PCHOutputFile);
+      if (objNode.PCHOutputFile.empty()) {
+        continue;
       }
+      auto producer = pch.find(objNode.PCHOutputFile);
+      if (producer != pch.end()) {
+        objNode.PreBuildDependencies.insert(producer->second);
+      } else if (!objNode.PCHInputFile.empty()) {
+        pch.emplace(objNode.PCHOutputFile, objNode.Name);
+        continue;
+      }
+      objNode.PCHInputFile.clear();
+      objNode.PCHOptions.clear();
+      objNode.PCHOutputFile.clear();
     }
   }
 
@@ -1148,13 +1558,20 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
   std::vector<std::string> SolutionBuildProjects;
   std::map<std::string, std::vector<std::string>> VSProjects, VSDependencies;
   std::set<std::string> allCustomCommands;
+  std::map<std::string, std::set<std::string>> scanTargets;
+  const std::string fragmentsDir =
+    cmStrCat(this->GetCMakeInstance()->GetHomeOutputDirectory(), '/',
+             FASTBUILD_FRAGMENTS_DIR);
+  std::set<std::string> fragments;
   for (const auto& targetName : orderedTargets) {
     auto& Target = FastbuildTargets[targetName];
 
     // Process target ExecNodes
-    // 1- If it has already been written, remove it from this Target
+    // 1- If it has already been written, remove it from this Target but
+    //    keep waiting for it
     // 2- If a ExecInput refers to a known target, replace with product name
     //    (this way we make sure we are waiting for all generations)
+    std::set<std::string> writtenExecs;
     for (auto it = Target.ExecNodes.begin(); it != Target.ExecNodes.end();) {
       if (allCustomCommands.insert(it->Name).second) {
         auto& target = *it;
@@ -1167,10 +1584,24 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
         }
         ++it;
       } else {
+        writtenExecs.insert(it->Name);
         it = Target.ExecNodes.erase(it);
       }
     }
 
+    // Every target is written to its own fragment, included by the build
+    // file. A fragment is only replaced when its content changes.
+    const std::string fragment =
+      cmStrCat(FASTBUILD_FRAGMENTS_DIR, '/', targetName, ".bff");
+    const std::string fragmentFile =
+      cmStrCat(fragmentsDir, '/', targetName, ".bff");
+    fragments.insert(fragmentFile);
+    cmGeneratedFileStream fragmentStream(fragmentFile, false,
+                                         this->GetMakefileEncoding());
+    fragmentStream.SetCopyIfDifferent(true);
+    cmGeneratedFileStream* buildFileStream =
+      std::exchange(this->BuildFileStream, &fragmentStream);
+
     this->WriteComment(*this->GetBuildFileStream(),
                        "Target definition: " + targetName);
     *this->GetBuildFileStream() << "{\n";
@@ -1186,9 +1617,30 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
     targetNodes.insert(dependencies.begin(), dependencies.end());
     dependencies = this->WriteExecs(Target.ExecNodes, dependencies);
     targetNodes.insert(dependencies.begin(), dependencies.end());
+    dependencies.insert(writtenExecs.begin(), writtenExecs.end());
+    auto unity = this->WriteUnity(Target.UnityNodes, dependencies);
+    targetNodes.insert(unity.begin(), unity.end());
     auto objectLists =
       this->WriteObjectLists(Target.ObjectListNodes, dependencies);
     targetNodes.insert(objectLists.begin(), objectLists.end());
+    for (const auto& moduleFragment : Target.ModuleFragments) {
+      fragments.insert(cmStrCat(fragmentsDir, '/', moduleFragment));
+      *this->BuildFileStream << "#include \"" << moduleFragment << "\"\n";
+    }
+    // The scan waits for generated sources and for the modules of the
+    // targets it depends on.
+    if (!Target.CollateExecNodes.empty()) {
+      auto scans = this->WriteExecs(Target.ScanExecNodes, dependencies);
+      for (const auto& dep : Target.Dependencies) {
+        if (!FastbuildTargets.at(dep).CollateExecNodes.empty()) {
+          scans.insert(dep + "-scan");
+        }
+      }
+      auto collated = this->WriteExecs(Target.CollateExecNodes, scans);
+      this->WriteAlias(Target.Name + "-scan", collated);
+      targetNodes.insert(Target.Name + "-scan");
+      scanTargets[Target.Config].insert(Target.Name + "-scan");
+    }
     dependencies =
       this->WriteExecs(Target.PreLinkExecNodes,
                        objectLists.empty() ? dependencies : objectLists);
@@ -1261,30 +1713,27 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
             cmSystemTools::ReplaceString(folderId, "+", "_");
             cmSystemTools::ReplaceString(folderId, "-", "_");
 
-            std::stringstream ss;
-            WriteVariable(ss, "Folder", Quote(folder), 3);
-            WriteArray(ss, "Files", Wrap(files), 3);
-            Indent(ss, 2);
-            ss << "]";
-            WriteVariable(*BuildFileStream, folderId, "[\n" + ss.str(), 2);
+            WriteStructBegin(*BuildFileStream, folderId, 2);
+            WriteVariable(*BuildFileStream, "Folder", Quote(folder), 3);
+            WriteQuotedArray(*BuildFileStream, "Files", files, 3);
+            WriteStructEnd(*BuildFileStream, 2);
 
             ProjectFilesWithFolders.push_back("." + folderId);
           }
         }
         if (!ProjectFiles.empty())
-          WriteArray(*BuildFileStream, "ProjectFiles", Wrap(ProjectFiles), 2);
+          WriteQuotedArray(*BuildFileStream, "ProjectFiles", ProjectFiles, 2);
         if (!ProjectFilesWithFolders.empty())
           WriteArray(*BuildFileStream, "ProjectFilesWithFolders",
                      ProjectFilesWithFolders, 2);
 
         if (!VCXProject.UserProps.empty()) {
-          std::stringstream ss;
-          WriteVariable(ss, "Condition",
+          WriteStructBegin(*BuildFileStream, "UserProps", 2);
+          WriteVariable(*BuildFileStream, "Condition",
                         Quote("Exists('" + VCXProject.UserProps + "')"), 3);
-          WriteVariable(ss, "Project", Quote(VCXProject.UserProps), 3);
-          Indent(ss, 2);
-          ss << "]";
-          WriteVariable(*BuildFileStream, "UserProps", "[\n" + ss.str(), 2);
+          WriteVariable(*BuildFileStream, "Project",
+                        Quote(VCXProject.UserProps), 3);
+          WriteStructEnd(*BuildFileStream, 2);
           WriteArray(*BuildFileStream, "ProjectProjectImports",
                      { ".UserProps" }, 2);
         }
@@ -1296,17 +1745,16 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
           WriteVariable(*BuildFileStream, "LocalDebuggerCommandArguments",
                         Quote(VCXProject.LocalDebuggerCommandArguments), 2);
         }
-        std::stringstream ss;
-        WriteVariable(ss, "Platform", Quote(VCXProject.Platform), 3);
-        WriteVariable(ss, "Config", Quote(VCXProject.Config), 3);
-        WriteVariable(ss, "Target", Quote(VCXProject.Target), 3);
-        WriteVariable(ss, "ProjectBuildCommand",
+        WriteStructBegin(*BuildFileStream, "ProjectConfigs", 2);
+        WriteVariable(*BuildFileStream, "Platform", Quote(VCXProject.Platform),
+                      3);
+        WriteVariable(*BuildFileStream, "Config", Quote(VCXProject.Config), 3);
+        WriteVariable(*BuildFileStream, "Target", Quote(VCXProject.Target), 3);
+        WriteVariable(*BuildFileStream, "ProjectBuildCommand",
                       Quote(VCXProject.ProjectBuildCommand), 3);
-        WriteVariable(ss, "ProjectRebuildCommand",
+        WriteVariable(*BuildFileStream, "ProjectRebuildCommand",
                       Quote(VCXProject.ProjectRebuildCommand), 3);
-        Indent(ss, 2);
-        ss << "]";
-        WriteVariable(*BuildFileStream, "ProjectConfigs", "[\n" + ss.str(), 2);
+        WriteStructEnd(*BuildFileStream, 2);
       }
       Indent(*BuildFileStream, 1);
       *BuildFileStream << "}\n";
@@ -1324,6 +1772,50 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
 #endif
 
     *this->GetBuildFileStream() << "}\n";
+
+    this->BuildFileStream = buildFileStream;
+    *this->BuildFileStream << "#include \"" << fragment << "\"\n";
+  }
+
+  // The "scan" aliases are built by a pass of their own before the build,
+  // see GenerateBuildCommand().
+  const std::string scanFile =
+    cmStrCat(this->GetCMakeInstance()->GetHomeOutputDirectory(), '/',
+             FASTBUILD_SCAN_FILE);
+  if (scanTargets.empty()) {
+    cmSystemTools::RemoveFile(scanFile);
+  } else {
+    cmGeneratedFileStream scanStream(scanFile, false,
+                                     this->GetMakefileEncoding());
+    scanStream.SetCopyIfDifferent(true);
+    cmGeneratedFileStream* buildFileStream =
+      std::exchange(this->BuildFileStream, &scanStream);
+    for (const auto& [config, scans] : scanTargets) {
+      this->WriteAlias(this->BuildAlias("scan", config), scans);
+      if (!this->DefaultFileConfig.empty() &&
+          config == this->DefaultFileConfig) {
+        this->WriteAlias("scan", scans);
+      }
+    }
+    this->BuildFileStream = buildFileStream;
+    *this->BuildFileStream << "#include \"" << FASTBUILD_SCAN_FILE << "\"\n";
+    fragments.insert(scanFile);
+  }
+
+  // Remove the fragments of targets that are gone, so they do not pile up
+  // in the build tree.
+  std::error_code ec;
+  std::vector<std::string> staleFragments;
+  for (auto const& entry :
+       std::filesystem::recursive_directory_iterator{ fragmentsDir, ec }) {
+    std::string const path = entry.path().generic_string();
+    if (entry.is_regular_file() && cmHasLiteralSuffix(path, ".bff") &&
+        fragments.find(path) == fragments.end()) {
+      staleFragments.push_back(path);
+    }
+  }
+  for (std::string const& path : staleFragments) {
+    cmSystemTools::RemoveFile(path);
   }
 
   // Write the VSSolution node on Windows
@@ -1342,14 +1834,12 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
       for (const auto& project : projects)
         SolutionProjects.push_back(project);
     }
-    WriteArray(*BuildFileStream, "SolutionProjects", Wrap(SolutionProjects),
-               1);
-    std::stringstream ss;
-    WriteVariable(ss, "Platform", Quote(VSPlatform), 2);
-    WriteVariable(ss, "Config", Quote(VSConfig), 2);
-    Indent(ss, 1);
-    ss << "]";
-    WriteVariable(*BuildFileStream, "SolutionConfig", "[\n" + ss.str(), 1);
+    WriteQuotedArray(*BuildFileStream, "SolutionProjects", SolutionProjects,
+                     1);
+    WriteStructBegin(*BuildFileStream, "SolutionConfig", 1);
+    WriteVariable(*BuildFileStream, "Platform", Quote(VSPlatform), 2);
+    WriteVariable(*BuildFileStream, "Config", Quote(VSConfig), 2);
+    WriteStructEnd(*BuildFileStream, 1);
     WriteArray(*BuildFileStream, "SolutionConfigs", { ".SolutionConfig" }, 1);
     std::vector<std::string> SolutionFolders;
     for (const auto& [folder, projects] : VSProjects) {
@@ -1363,12 +1853,10 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
       cmSystemTools::ReplaceString(folderId, "+", "_");
       cmSystemTools::ReplaceString(folderId, "-", "_");
 
-      std::stringstream ss;
-      WriteVariable(ss, "Path", Quote(folder), 2);
-      WriteArray(ss, "Projects", Wrap(projects), 2);
-      Indent(ss, 1);
-      ss << "]";
-      WriteVariable(*BuildFileStream, folderId, "[\n" + ss.str(), 1);
+      WriteStructBegin(*BuildFileStream, folderId, 1);
+      WriteVariable(*BuildFileStream, "Path", Quote(folder), 2);
+      WriteQuotedArray(*BuildFileStream, "Projects", projects, 2);
+      WriteStructEnd(*BuildFileStream, 1);
 
       SolutionFolders.push_back("." + folderId);
     }
@@ -1381,12 +1869,11 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
 
       cmSystemTools::ReplaceString(depsId, "-", "_");
 
-      std::stringstream ss;
-      WriteArray(ss, "Projects", Wrap(std::vector<std::string>{ project }), 2);
-      WriteArray(ss, "Dependencies", Wrap(dependencies), 2);
-      Indent(ss, 1);
-      ss << "]";
-      WriteVariable(*BuildFileStream, depsId, "[\n" + ss.str(), 1);
+      WriteStructBegin(*BuildFileStream, depsId, 1);
+      WriteQuotedArray(*BuildFileStream, "Projects",
+                       std::vector<std::string>{ project }, 2);
+      WriteQuotedArray(*BuildFileStream, "Dependencies", dependencies, 2);
+      WriteStructEnd(*BuildFileStream, 1);
 
       SolutionDependencies.push_back("." + depsId);
     }
@@ -1394,13 +1881,98 @@ void cmGlobalFastbuildGenerator::WriteTargets(std::ostream& os)
       WriteArray(*BuildFileStream, "SolutionDependencies",
                  SolutionDependencies, 1);
 
-    WriteArray(*BuildFileStream, "SolutionBuildProject",
-               Wrap(SolutionBuildProjects), 1);
+    WriteQuotedArray(*BuildFileStream, "SolutionBuildProject",
+                     SolutionBuildProjects, 1);
   }
   *BuildFileStream << "}\n";
 #endif
 }
 
+void cmGlobalFastbuildGenerator::WriteNodeMap()
+{
+  Json::Value root(Json::objectValue);
+  root["version"] = 1;
+  root["buildDirectory"] = this->GetCMakeInstance()->GetHomeOutputDirectory();
+
+  Json::Value& targets = root["targets"] = Json::objectValue;
+  Json::Value& nodes = root["nodes"] = Json::arrayValue;
+  for (const auto& [Name, Target] : FastbuildTargets) {
+    Json::Value& target = targets[Name] = Json::objectValue;
+    target["config"] = Target.Config;
+    if (Target.GeneratorTarget) {
+      target["name"] = Target.GeneratorTarget->GetName();
+      target["sourceDirectory"] = Target.GeneratorTarget->GetLocalGenerator()
+                                    ->GetCurrentSourceDirectory();
+      cmListFileBacktrace backtrace = Target.GeneratorTarget->GetBacktrace();
+      if (!backtrace.Empty()) {
+        target["backtrace"] = cmStrCat(backtrace.Top().FilePath, ':',
+                                       backtrace.Top().Line);
+      }
+    } else {
+      target["name"] = Name;
+    }
+    Json::Value& dependencies = target["dependencies"] = Json::arrayValue;
+    for (const auto& dependency : Target.Dependencies) {
+      dependencies.append(dependency);
+    }
+
+    auto addNode = [&nodes, &Name](const std::string& nodeName,
+                                   const char* type) -> Json::Value& {
+      Json::Value& node = nodes.append(Json::objectValue);
+      node["name"] = nodeName;
+      node["type"] = type;
+      node["target"] = Name;
+      return node;
+    };
+
+    std::map<std::string, std::string> unityLanguages;
+    for (const auto& objectList : Target.ObjectListNodes) {
+      Json::Value& node = addNode(objectList.Name, "ObjectList");
+      node["language"] = objectList.Language;
+      node["outputDirectory"] = objectList.CompilerOutputPath;
+      if (!objectList.CompilerInputUnity.empty()) {
+        unityLanguages[objectList.CompilerInputUnity] = objectList.Language;
+      }
+    }
+    for (const auto& unity : Target.UnityNodes) {
+      Json::Value& node = addNode(unity.Name, "Unity");
+      node["language"] = unityLanguages[unity.Name];
+      node["outputDirectory"] = unity.UnityOutputPath;
+    }
+    for (const auto& linker : Target.LinkerNodes) {
+      Json::Value& node = addNode(linker.Name, "Linker");
+      node["outputs"].append(linker.LinkerOutput);
+    }
+    for (const auto* execs :
+         { &Target.PreBuildExecNodes, &Target.ExecNodes,
+           &Target.ScanExecNodes, &Target.CollateExecNodes,
+           &Target.PreLinkExecNodes, &Target.PostBuildExecNodes }) {
+      for (const auto& exec : *execs) {
+        Json::Value& node = addNode(exec.Name, "Exec");
+        Json::Value& outputs = node["outputs"] = Json::arrayValue;
+        if (!exec.ExecOutput.empty()) {
+          outputs.append(exec.ExecOutput);
+        }
+        for (const auto& output : exec.ExecOutputs) {
+          if (output != exec.ExecOutput) {
+            outputs.append(output);
+          }
+        }
+      }
+    }
+  }
+
+  cmGeneratedFileStream fout(
+    cmStrCat(this->GetCMakeInstance()->GetHomeOutputDirectory(), '/',
+             FASTBUILD_NODE_MAP_FILE));
+  fout.SetCopyIfDifferent(true);
+  Json::StreamWriterBuilder wbuilder;
+  wbuilder["indentation"] = "  ";
+  std::unique_ptr<Json::StreamWriter> jout(wbuilder.newStreamWriter());
+  jout->write(root, &fout);
+  fout << '\n';
+}
+
 std::string cmGlobalFastbuildGenerator::GetTargetName(
   const cmGeneratorTarget* GeneratorTarget) const
 {
@@ -1450,3 +2022,61 @@ bool cmGlobalFastbuildGenerator::Open(const std::string& bindir,
   return cmGlobalCommonGenerator::Open(bindir, projectName, dryRun);
 #endif
 }
+
+cmGlobalFastbuildMultiGenerator::cmGlobalFastbuildMultiGenerator(cmake* cm)
+  : cmGlobalFastbuildGenerator(cm)
+{
+  cm->GetState()->SetIsGeneratorMultiConfig(true);
+}
+
+std::unique_ptr<cmGlobalGeneratorFactory>
+cmGlobalFastbuildMultiGenerator::NewFactory()
+{
+  return std::unique_ptr<cmGlobalGeneratorFactory>(
+    new cmGlobalGeneratorSimpleFactory<cmGlobalFastbuildMultiGenerator>());
+}
+
+void cmGlobalFastbuildMultiGenerator::GetDocumentation(
+  cmDocumentationEntry& entry)
+{
+  entry.Name = cmGlobalFastbuildMultiGenerator::GetActualName();
+  entry.Brief = "Generates build.bff files for all configurations.";
+}
+
+std::string cmGlobalFastbuildMultiGenerator::ExpandCFGIntDir(
+  const std::string& str, const std::string& config) const
+{
+  std::string result = str;
+  cmSystemTools::ReplaceString(result, this->GetCMakeCFGIntDir(), config);
+  return result;
+}
+
+void cmGlobalFastbuildMultiGenerator::EnableLanguage(
+  std::vector<std::string> const& languages, cmMakefile* mf, bool optional)
+{
+  mf->InitCMAKE_CONFIGURATION_TYPES("Debug;Release;RelWithDebInfo");
+  this->cmGlobalFastbuildGenerator::EnableLanguage(languages, mf, optional);
+}
+
+bool cmGlobalFastbuildMultiGenerator::InspectConfigTypeVariables()
+{
+  std::vector<std::string> configs =
+    this->Makefiles.front()->GetGeneratorConfigs(
+      cmMakefile::IncludeEmptyConfig);
+
+  this->DefaultFileConfig =
+    this->Makefiles.front()->GetSafeDefinition("CMAKE_DEFAULT_BUILD_TYPE");
+  if (this->DefaultFileConfig.empty()) {
+    this->DefaultFileConfig = configs.front();
+  }
+  if (std::find(configs.begin(), configs.end(), this->DefaultFileConfig) ==
+      configs.end()) {
+    this->GetCMakeInstance()->IssueMessage(
+      MessageType::FATAL_ERROR,
+      cmStrCat("The configuration specified by CMAKE_DEFAULT_BUILD_TYPE (",
+               this->DefaultFileConfig,
+               ") is not present in CMAKE_CONFIGURATION_TYPES"));
+    return false;
+  }
+  return true;
+}
@@ -14,10 +14,20 @@
 
 #include "cmConfigure.h" // IWYU pragma: keep
 
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <unordered_map>
 #include <utility>
+#include <vector>
+
+#include <cm/optional>
+#include <cm/string_view>
 
 #include "cmGlobalCommonGenerator.h"
 #include "cmStateTypes.h"
+#include "cmStringAlgorithms.h"
+#include "cmTransformDepfile.h"
 
 #define FASTBUILD_DOLLAR_TAG "FASTBUILD_DOLLAR_TAG"
 
@@ -35,6 +45,16 @@ public:
   /// The default name of Fastbuild's build file. Typically: fbuild.bff.
   static const char* FASTBUILD_BUILD_FILE;
 
+  /// The directory, relative to the build file, of the per-target files.
+  static const char* FASTBUILD_FRAGMENTS_DIR;
+
+  /// The file, relative to the build file, mapping nodes to CMake targets.
+  static const char* FASTBUILD_NODE_MAP_FILE;
+
+  /// The file, relative to the build file, defining the "scan" aliases.
+  /// It only exists when sources must be scanned for modules.
+  static const char* FASTBUILD_SCAN_FILE;
+
   /// The indentation string used when generating Fastbuild's build file.
   static const char* INDENT;
 
@@ -71,6 +91,13 @@ public:
 
   static std::string GetActualName() { return "Fastbuild"; }
 
+  /// Name of the node building @a alias in @a config.
+  virtual std::string BuildAlias(const std::string& alias,
+                                 const std::string& /*config*/) const
+  {
+    return alias;
+  }
+
   const char* GetAllTargetName() const override { return "all"; }
   const char* GetInstallTargetName() const override { return "install"; }
   const char* GetCleanTargetName() const override { return "clean"; }
@@ -101,8 +128,18 @@ public:
 
   bool IsIPOSupported() const override { return true; }
 
+  bool SupportsCustomCommandDepfile() const override { return true; }
+  cm::optional<cmDepfileFormat> DepfileFormat() const override
+  {
+    return cmDepfileFormat::FastbuildExecInput;
+  }
+
   static std::string RequiredFastbuildVersion() { return "1.00"; }
 
+  /// First Fastbuild version whose Exec nodes accept several outputs.
+  static std::string ExecOutputsFastbuildVersion() { return "1.12"; }
+  bool SupportsExecOutputs() const { return this->FastbuildExecOutputs; }
+
   void OpenBuildFileStream();
   void CloseBuildFileStream();
 
@@ -127,18 +164,11 @@ public:
 
   void WriteBuildFileTop(std::ostream& os);
 
-  static std::string Quote(const std::string& str,
-                           const std::string& quotation = "'");
-
-  static std::vector<std::string> Wrap(const std::vector<std::string>& in,
-                                       const std::string& prefix = "'",
-                                       const std::string& suffix = "'",
-                                       const bool escape_dollar = true);
+  /// Compute the "NAME=value" entries of the Settings.Environment block.
+  static std::vector<std::string> ComputeEnvironment(cmMakefile* mf);
 
-  static std::vector<std::string> Wrap(const std::set<std::string>& in,
-                                       const std::string& prefix = "'",
-                                       const std::string& suffix = "'",
-                                       const bool escape_dollar = true);
+  static std::string Quote(cm::string_view str,
+                           cm::string_view quotation = "'");
 
   static void WriteDivider(std::ostream& os);
   static void WriteComment(std::ostream& os, const std::string& comment,
@@ -162,48 +192,160 @@ public:
                          const std::vector<std::string>& values,
                          const std::string& op, int indent = 0);
 
+  /**
+   * Write @a values as an array of single quoted strings. The values are
+   * quoted and, when @a escapeDollar is set, escaped while they are
+   * streamed, no intermediate list is built.
+   */
+  template <typename Container>
+  static void WriteQuotedArray(std::ostream& os, const std::string& key,
+                               const Container& values, int indent = 0,
+                               bool escapeDollar = true)
+  {
+    WriteVariable(os, key, std::string(), "=", indent);
+    Indent(os, indent);
+    os << "{\n";
+    bool first = true;
+    for (const auto& value : values) {
+      if (!first) {
+        os << ",\n";
+      }
+      first = false;
+      Indent(os, indent + 1);
+      WriteQuoted(os, value, escapeDollar);
+    }
+    if (!first) {
+      os << '\n';
+    }
+    Indent(os, indent);
+    os << "}\n";
+  }
+
+  /// Write @a value in single quotes, '$' escaped if @a escapeDollar.
+  static void WriteQuoted(std::ostream& os, cm::string_view value,
+                          bool escapeDollar = true);
+
+  /// Open and close a '.key = [ ... ]' struct at @a indent.
+  static void WriteStructBegin(std::ostream& os, const std::string& key,
+                               int indent = 0);
+  static void WriteStructEnd(std::ostream& os, int indent = 0);
+
+  /**
+   * Sort @a source so every element comes after the elements it depends on.
+   * Independent elements keep their input order. Dependencies on elements
+   * that are not in @a source are ignored. Elements that cannot be sorted
+   * are appended in input order, those on a dependency cycle are returned.
+   */
   template <typename T>
-  static void SortByDependencies(
+  static std::vector<T> SortByDependencies(
     std::vector<T>& source, const std::unordered_multimap<T, T>& dependencies)
   {
-    std::vector<T> output;
+    std::unordered_map<T, size_t> indices;
+    indices.reserve(source.size());
+    for (size_t i = 0; i < source.size(); ++i) {
+      indices.emplace(source[i], i);
+    }
+
+    std::vector<size_t> pending(source.size(), 0);
+    std::vector<std::vector<size_t>> dependents(source.size());
+    for (const auto& [node, dependency] : dependencies) {
+      auto nt = indices.find(node);
+      auto dt = indices.find(dependency);
+      if (nt != indices.end() && dt != indices.end()) {
+        ++pending[nt->second];
+        dependents[dt->second].push_back(nt->second);
+      }
+    }
 
-    std::unordered_multimap<T, T> reverseDependencies;
-    for (auto it = dependencies.begin(); it != dependencies.end(); ++it) {
-      auto range = dependencies.equal_range(it->first);
-      for (auto jt = range.first; jt != range.second; ++jt) {
-        reverseDependencies.emplace(jt->second, jt->first);
+    // Always emit the ready element that came first in the input.
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>>
+      ready;
+    for (size_t i = 0; i < source.size(); ++i) {
+      if (pending[i] == 0) {
+        ready.push(i);
       }
     }
 
-    auto forwardDependencies = dependencies;
-    while (!source.empty()) {
-      for (auto it = source.begin(); it != source.end();) {
-        auto targetName = *it;
-        if (forwardDependencies.find(targetName) ==
-            forwardDependencies.end()) {
-          output.push_back(targetName);
-          it = source.erase(it);
-
-          auto range = reverseDependencies.equal_range(targetName);
-          for (auto rt = range.first; rt != range.second; ++rt) {
-            // Fetch the list of deps on that target
-            auto frange = forwardDependencies.equal_range(rt->second);
-            for (auto ft = frange.first; ft != frange.second;) {
-              if (ft->second == targetName) {
-                ft = forwardDependencies.erase(ft);
-              } else {
-                ++ft;
-              }
-            }
+    std::vector<T> output;
+    output.reserve(source.size());
+    std::vector<bool> emitted(source.size(), false);
+    while (!ready.empty()) {
+      size_t const i = ready.top();
+      ready.pop();
+      emitted[i] = true;
+      output.push_back(source[i]);
+      for (size_t const dependent : dependents[i]) {
+        if (--pending[dependent] == 0) {
+          ready.push(dependent);
+        }
+      }
+    }
+
+    // The elements left are on a cycle or depend on one. Only the strongly
+    // connected components are cycles, find them with an iterative
+    // Tarjan's algorithm.
+    size_t const unvisited = source.size();
+    std::vector<size_t> index(source.size(), unvisited);
+    std::vector<size_t> lowlink(source.size());
+    std::vector<size_t> stackPosition(source.size(), unvisited);
+    std::vector<bool> onCycle(source.size(), false);
+    std::vector<size_t> stack;
+    std::vector<std::pair<size_t, size_t>> work;
+    size_t counter = 0;
+    auto visit = [&](size_t i) {
+      index[i] = lowlink[i] = counter++;
+      stackPosition[i] = stack.size();
+      stack.push_back(i);
+      work.emplace_back(i, 0);
+    };
+    for (size_t root = 0; root < source.size(); ++root) {
+      if (emitted[root] || index[root] != unvisited) {
+        continue;
+      }
+      visit(root);
+      while (!work.empty()) {
+        size_t const i = work.back().first;
+        size_t const edge = work.back().second++;
+        if (edge < dependents[i].size()) {
+          size_t const dependent = dependents[i][edge];
+          if (index[dependent] == unvisited) {
+            visit(dependent);
+          } else if (stackPosition[dependent] != unvisited) {
+            lowlink[i] = std::min(lowlink[i], index[dependent]);
+          }
+          continue;
+        }
+        work.pop_back();
+        if (!work.empty()) {
+          size_t const parent = work.back().first;
+          lowlink[parent] = std::min(lowlink[parent], lowlink[i]);
+        }
+        if (lowlink[i] == index[i]) {
+          size_t const begin = stackPosition[i];
+          bool const cyclic = stack.size() - begin > 1 ||
+            std::find(dependents[i].begin(), dependents[i].end(), i) !=
+              dependents[i].end();
+          for (size_t k = begin; k < stack.size(); ++k) {
+            onCycle[stack[k]] = cyclic;
+            stackPosition[stack[k]] = unvisited;
           }
-        } else {
-          ++it;
+          stack.resize(begin);
+        }
+      }
+    }
+
+    std::vector<T> cycle;
+    for (size_t i = 0; i < source.size(); ++i) {
+      if (!emitted[i]) {
+        output.push_back(source[i]);
+        if (onCycle[i]) {
+          cycle.push_back(source[i]);
         }
       }
     }
 
     std::swap(output, source);
+    return cycle;
   }
 
   /// Write the common disclaimer text at the top of each build file.
@@ -211,7 +353,10 @@ public:
 
   void WriteCompilers(std::ostream& os);
 
-  void WriteTargets(std::ostream& os);
+  void WriteTargets();
+
+  /// Write FASTBUILD_NODE_MAP_FILE, which maps every node to its target.
+  void WriteNodeMap();
 
   void AddCompiler(const std::string& lang, cmMakefile* mf);
 
@@ -230,6 +375,18 @@ public:
     bool useLightCache = false;
   };
 
+  struct FastbuildUnityNode
+  {
+    std::string Name;
+    std::string UnityOutputPath;
+    std::string UnityOutputPattern;
+    std::vector<std::string> UnityInputFiles;
+    std::string UnityInputIsolateListFile;
+    int UnityNumFiles = 1;
+    int UnityInputIsolateWritableFilesLimit = 0;
+    bool UnityInputIsolateWritableFiles = false;
+  };
+
   struct FastbuildObjectListNode
   {
     std::string Name;
@@ -240,6 +397,16 @@ public:
     std::string PCHInputFile;
     std::string PCHOutputFile;
     std::string PCHOptions;
+    std::string CompilerInputUnity;
+    std::string CompilerInputFilesRoot;
+    /// Language of the sources, for the node map only.
+    std::string Language;
+    /// Only the settings are written, as a struct. The ObjectList is
+    /// defined by the module fragment of the target, see
+    /// cmFastbuildModules.
+    bool ScanModules = false;
+    bool AllowCaching = true;
+    bool AllowDistribution = true;
 
     std::vector<std::string> CompilerInputFiles;
     std::set<std::string> PreBuildDependencies;
@@ -291,7 +458,11 @@ public:
     std::string ExecWorkingDir;
     bool ExecUseStdOutAsOutput = false;
     std::string ExecOutput;
+    /// All outputs, only used when Fastbuild supports ExecOutputs.
+    std::vector<std::string> ExecOutputs;
     std::vector<std::string> ExecInput;
+    /// Fragment the command writes its discovered dependencies to.
+    std::string DepfileFragment;
     std::set<std::string> PreBuildDependencies;
     bool ExecAlways = false;
     bool IsNoop = false;
@@ -307,25 +478,38 @@ public:
   {
     std::string Name;
     std::map<std::string, std::string> Variables;
+    std::vector<FastbuildUnityNode> UnityNodes;
     std::vector<FastbuildObjectListNode> ObjectListNodes;
     std::vector<FastbuildLinkerNode> LinkerNodes;
     std::vector<FastbuildVCXProject> VCXProjects;
     std::vector<FastbuildExecNode> PreBuildExecNodes, PreLinkExecNodes,
       PostBuildExecNodes, ExecNodes;
     std::vector<FastbuildAliasNode> AliasNodes;
+    /// Scanning the sources for modules and collating the result into
+    /// ModuleFragments, built by the pass before the build.
+    std::vector<FastbuildExecNode> ScanExecNodes, CollateExecNodes;
+    std::vector<std::string> ModuleFragments;
     std::vector<std::string> Dependencies;
+    std::string Config;
+    /// The CMake target, null for the targets the generator adds itself.
+    cmGeneratorTarget const* GeneratorTarget = nullptr;
     bool IsGlobal = false;
     bool IsExcluded = false;
   };
 
   std::string GetTargetName(const cmGeneratorTarget* GeneratorTarget) const;
 
-  void AddTarget(const FastbuildTarget& target);
+  /// Value of a build time option, from the environment or else the cache.
+  std::string GetBuildOption(const std::string& name) const;
+
+  void AddTarget(FastbuildTarget&& target);
 
   bool IsExcluded(cmGeneratorTarget* target);
 
   std::set<std::string> WriteExecs(const std::vector<FastbuildExecNode>&,
                                    const std::set<std::string>&);
+  std::set<std::string> WriteUnity(const std::vector<FastbuildUnityNode>&,
+                                   const std::set<std::string>&);
   std::set<std::string> WriteObjectLists(
     const std::vector<FastbuildObjectListNode>&, const std::set<std::string>&);
   std::set<std::string> WriteLinker(const std::vector<FastbuildLinkerNode>&,
@@ -342,9 +526,63 @@ public:
 
   std::string FastbuildCommand;
   std::string FastbuildVersion;
+  bool FastbuildExecOutputs = false;
 
   std::map<std::string, std::unique_ptr<cmFastbuildTargetGenerator>> Targets;
   std::unordered_multimap<std::string, std::string> TargetDependencies;
+
+  /// Configuration the unsuffixed target names build, if multi-config.
+  std::string DefaultFileConfig;
+};
+
+/** \class cmGlobalFastbuildMultiGenerator
+ * \brief Fastbuild generator building all configurations from one bff.
+ *
+ * Every target is generated once per configuration. Node names get a
+ * "-<Config>" suffix and objects go to a directory per configuration,
+ * compilers and configuration independent custom commands are shared.
+ * The unsuffixed names build CMAKE_DEFAULT_BUILD_TYPE.
+ */
+class cmGlobalFastbuildMultiGenerator : public cmGlobalFastbuildGenerator
+{
+public:
+  cmGlobalFastbuildMultiGenerator(cmake* cm);
+
+  static std::unique_ptr<cmGlobalGeneratorFactory> NewFactory();
+
+  static void GetDocumentation(cmDocumentationEntry& entry);
+
+  std::string GetName() const override
+  {
+    return cmGlobalFastbuildMultiGenerator::GetActualName();
+  }
+
+  static std::string GetActualName() { return "Fastbuild Multi-Config"; }
+
+  bool IsMultiConfig() const override { return true; }
+
+  std::string BuildAlias(const std::string& alias,
+                         const std::string& config) const override
+  {
+    if (config.empty()) {
+      return alias;
+    }
+    return cmStrCat(alias, '-', config);
+  }
+
+  const char* GetCMakeCFGIntDir() const override { return "${CONFIGURATION}"; }
+
+  std::string ExpandCFGIntDir(const std::string& str,
+                              const std::string& config) const override;
+
+  void EnableLanguage(std::vector<std::string> const& languages,
+                      cmMakefile* mf, bool optional) override;
+
+  bool InspectConfigTypeVariables() override;
+
+  std::string GetDefaultBuildConfig() const override { return ""; }
+
+  bool SupportsDefaultBuildType() const override { return true; }
 };
 
 #endif
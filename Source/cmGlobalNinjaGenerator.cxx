@@ -2377,6 +2377,7 @@ cm::optional<cmSourceInfo> cmcmd_cmake_ninja_depends_fortran(
   cm::optional<cmSourceInfo> info;
   cmFortranCompiler fc;
   std::vector<std::string> includes;
+  std::set<std::string> defines;
   std::string dir_top_bld;
   std::string module_dir;
   {
@@ -2419,10 +2420,17 @@ cm::optional<cmSourceInfo> cmcmd_cmake_ninja_depends_fortran(
 
     Json::Value const& tdi_submodule_ext = tdi["submodule-ext"];
     fc.SModExt = tdi_submodule_ext.asString();
+
+    // Set when the source is scanned before it is preprocessed.
+    Json::Value const& tdi_defines = tdi["defines"];
+    if (tdi_defines.isArray()) {
+      for (auto const& tdi_define : tdi_defines) {
+        defines.insert(tdi_define.asString());
+      }
+    }
   }
 
   cmFortranSourceInfo finfo;
-  std::set<std::string> defines;
   cmFortranParser parser(fc, includes, defines, finfo);
   if (!cmFortranParser_FilePush(&parser, arg_pp.c_str())) {
     cmSystemTools::Error(
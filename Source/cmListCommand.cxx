@@ -7,6 +7,7 @@
 #include <cstdio>
 #include <functional>
 #include <iterator>
+#include <memory>
 #include <set>
 #include <sstream>
 #include <stdexcept>
@@ -586,20 +587,21 @@ public:
 class TransformSelectorRegex : public TransformSelector
 {
 public:
-  TransformSelectorRegex(const std::string& regex)
+  TransformSelectorRegex(const std::string& regex, cmMakefile const& mf)
     : TransformSelector("REGEX")
-    , Regex(regex)
+    , Regex(mf.GetRegularExpression(regex))
   {
   }
 
-  bool Validate(std::size_t) override { return this->Regex.is_valid(); }
+  bool Validate(std::size_t) override { return this->Regex != nullptr; }
 
   bool InSelection(const std::string& value) override
   {
-    return this->Regex.find(value);
+    return this->Regex->find(value.c_str(), this->Match);
   }
 
-  cmsys::RegularExpression Regex;
+  std::shared_ptr<cmsys::RegularExpression const> Regex;
+  cmsys::RegularExpressionMatch Match;
 };
 class TransformSelectorIndexes : public TransformSelector
 {
@@ -926,7 +928,8 @@ bool HandleTransformCommand(std::vector<std::string> const& args,
         return false;
       }
 
-      command.Selector = cm::make_unique<TransformSelectorRegex>(args[index]);
+      command.Selector = cm::make_unique<TransformSelectorRegex>(
+        args[index], status.GetMakefile());
       if (!command.Selector->Validate()) {
         status.SetError(
           cmStrCat("sub-command TRANSFORM, selector REGEX failed to compile "
@@ -1472,7 +1475,8 @@ bool HandleFilterCommand(std::vector<std::string> const& args,
 class MatchesRegex
 {
 public:
-  MatchesRegex(cmsys::RegularExpression& in_regex, bool in_includeMatches)
+  MatchesRegex(cmsys::RegularExpression const& in_regex,
+               bool in_includeMatches)
     : regex(in_regex)
     , includeMatches(in_includeMatches)
   {
@@ -1480,11 +1484,13 @@ public:
 
   bool operator()(const std::string& target)
   {
-    return this->regex.find(target) ^ this->includeMatches;
+    return this->regex.find(target.c_str(), this->match) ^
+      this->includeMatches;
   }
 
 private:
-  cmsys::RegularExpression& regex;
+  cmsys::RegularExpression const& regex;
+  cmsys::RegularExpressionMatch match;
   const bool includeMatches;
 };
 
@@ -1494,8 +1500,8 @@ bool FilterRegex(std::vector<std::string> const& args, bool includeMatches,
                  cmExecutionStatus& status)
 {
   const std::string& pattern = args[4];
-  cmsys::RegularExpression regex(pattern);
-  if (!regex.is_valid()) {
+  auto regex = status.GetMakefile().GetRegularExpression(pattern);
+  if (!regex) {
     std::string error =
       cmStrCat("sub-command FILTER, mode REGEX failed to compile regex \"",
                pattern, "\".");
@@ -1506,7 +1512,7 @@ bool FilterRegex(std::vector<std::string> const& args, bool includeMatches,
   auto argsBegin = varArgsExpanded.begin();
   auto argsEnd = varArgsExpanded.end();
   auto newArgsEnd =
-    std::remove_if(argsBegin, argsEnd, MatchesRegex(regex, includeMatches));
+    std::remove_if(argsBegin, argsEnd, MatchesRegex(*regex, includeMatches));
 
   std::string value = cmJoin(cmMakeRange(argsBegin, newArgsEnd), ";");
   status.GetMakefile().AddDefinition(listName, value);
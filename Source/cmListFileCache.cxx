@@ -3,6 +3,7 @@
 #include "cmListFileCache.h"
 
 #include <cassert>
+#include <ctime>
 #include <memory>
 #include <sstream>
 #include <utility>
@@ -48,6 +49,7 @@ struct cmListFileParser
     SeparationWarning,
     SeparationError
   } Separation;
+  bool Warned = false;
 };
 
 cmListFileParser::cmListFileParser(cmListFile* lf, cmListFileBacktrace lfbt,
@@ -200,6 +202,48 @@ bool cmListFile::ParseFile(const char* filename, cmMessenger* messenger,
   return !parseError;
 }
 
+std::shared_ptr<cmListFile const> cmListFileCache::Parse(
+  std::string const& path, cmMessenger* messenger,
+  cmListFileBacktrace const& lfbt)
+{
+  cmSystemTools::Stat_t st;
+  if (cmSystemTools::Stat(path, &st) != 0 ||
+      cmSystemTools::FileIsDirectory(path)) {
+    return nullptr;
+  }
+  long long const mtime = static_cast<long long>(st.st_mtime);
+  long long const size = static_cast<long long>(st.st_size);
+
+  auto it = this->Entries.find(path);
+  if (it != this->Entries.end() && it->second.ModificationTime == mtime &&
+      it->second.Size == size) {
+    ++this->Hits;
+    return it->second.ListFile;
+  }
+  ++this->Misses;
+
+  auto listFile = std::make_shared<cmListFile>();
+  bool warned;
+  {
+    cmListFileParser parser(listFile.get(), lfbt, messenger);
+    if (!parser.ParseFile(path.c_str())) {
+      this->Entries.erase(path);
+      return nullptr;
+    }
+    warned = parser.Warned;
+  }
+
+  // The time has a resolution of one second, a file written in the second
+  // it was parsed in may be written again without changing it.  Files with
+  // warnings are parsed again to repeat them for every read.
+  if (!warned && std::time(nullptr) - mtime >= 2) {
+    this->Entries[path] = Entry{ listFile, mtime, size };
+  } else {
+    this->Entries.erase(path);
+  }
+  return listFile;
+}
+
 bool cmListFile::ParseString(const char* str, const char* virtual_filename,
                              cmMessenger* messenger,
                              const cmListFileBacktrace& lfbt)
@@ -335,6 +379,7 @@ bool cmListFileParser::AddArgument(cmListFileLexer_Token* token,
     return false;
   }
   this->Messenger->IssueMessage(MessageType::AUTHOR_WARNING, m.str(), lfbt);
+  this->Warned = true;
   return true;
 }
 
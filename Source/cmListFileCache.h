@@ -8,6 +8,7 @@
 #include <iosfwd>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -16,13 +17,6 @@
 #include "cmStateSnapshot.h"
 #include "cmSystemTools.h"
 
-/** \class cmListFileCache
- * \brief A class to cache list file contents.
- *
- * cmListFileCache is a class used to cache the contents of parsed
- * cmake list files.
- */
-
 class cmMessenger;
 
 struct cmCommandContext
@@ -279,3 +273,40 @@ struct cmListFile
 
   std::vector<cmListFileFunction> Functions;
 };
+
+/** \class cmListFileCache
+ * \brief A class to cache list file contents.
+ *
+ * cmListFileCache keeps the functions of the list files it parsed, so that
+ * a module included by every directory is parsed once per run.  An entry
+ * is used as long as the file has the modification time and size it had
+ * when it was parsed.  Files modified shortly before they were parsed, as
+ * files written during the configure step are, may change again without
+ * either, so they are parsed on every read.
+ */
+class cmListFileCache
+{
+public:
+  /**
+   * Parse the file at the collapsed full @a path or return the functions
+   * parsed before.  Returns null if the file does not exist or has errors.
+   */
+  std::shared_ptr<cmListFile const> Parse(std::string const& path,
+                                          cmMessenger* messenger,
+                                          cmListFileBacktrace const& lfbt);
+
+  std::size_t GetHits() const { return this->Hits; }
+  std::size_t GetMisses() const { return this->Misses; }
+
+private:
+  struct Entry
+  {
+    std::shared_ptr<cmListFile const> ListFile;
+    long long ModificationTime;
+    long long Size;
+  };
+
+  std::unordered_map<std::string, Entry> Entries;
+  std::size_t Hits = 0;
+  std::size_t Misses = 0;
+};
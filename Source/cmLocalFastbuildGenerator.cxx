@@ -11,6 +11,9 @@
 ============================================================================*/
 #include "cmLocalFastbuildGenerator.h"
 
+#include <memory>
+#include <utility>
+
 #include "cmCustomCommandGenerator.h"
 #include "cmFastbuildTargetGenerator.h"
 #include "cmGeneratorTarget.h"
@@ -32,16 +35,21 @@ cmLocalFastbuildGenerator::cmLocalFastbuildGenerator(cmGlobalGenerator* gg,
 
 void cmLocalFastbuildGenerator::Generate()
 {
+  // Targets are generated one after the other.  Generating a target fills
+  // caches of cmGeneratorTarget and cmMakefile on first use and registers
+  // compilers and launchers in the global generator, none of which may
+  // run on several threads at once.
   const auto& targets = this->GetGeneratorTargets();
   for (const auto& target : targets) {
     if (target->GetType() == cmStateEnums::INTERFACE_LIBRARY) {
       continue;
     }
-    cmFastbuildTargetGenerator* tg =
-      cmFastbuildTargetGenerator::New(target.get());
-    if (tg) {
-      tg->Generate();
-      delete tg;
+    for (std::string const& config : this->GetConfigNames()) {
+      std::unique_ptr<cmFastbuildTargetGenerator> tg(
+        cmFastbuildTargetGenerator::New(target.get(), config));
+      if (tg) {
+        tg->Generate();
+      }
     }
   }
 
@@ -51,32 +59,37 @@ void cmLocalFastbuildGenerator::Generate()
     auto AllTargetName =
       GetGlobalFastbuildGenerator()->ConvertToFastbuildPath(currentBinaryDir);
 
-    cmGlobalFastbuildGenerator::FastbuildTarget allTarget;
-    cmGlobalFastbuildGenerator::FastbuildAliasNode allNode;
-    allTarget.IsGlobal = true;
-    allTarget.Name = allNode.Name = AllTargetName + "/all";
-    for (const auto& Target : AllTargets[AllTargetName]) {
-      allNode.Targets.insert(Target + "-products");
-      allTarget.Dependencies.push_back(Target);
-    }
-    if (allNode.Targets.empty()) {
-      allNode.Targets.insert("noop-products");
-      allTarget.Dependencies.push_back("noop");
-    }
+    for (std::string const& config : this->GetConfigNames()) {
+      cmGlobalFastbuildGenerator::FastbuildTarget allTarget;
+      cmGlobalFastbuildGenerator::FastbuildAliasNode allNode;
+      allTarget.IsGlobal = true;
+      allTarget.Config = config;
+      allTarget.Name = allNode.Name =
+        GetGlobalFastbuildGenerator()->BuildAlias(AllTargetName + "/all",
+                                                  config);
+      for (const auto& Target : AllTargets[{ AllTargetName, config }]) {
+        allNode.Targets.insert(Target + "-products");
+        allTarget.Dependencies.push_back(Target);
+      }
+      if (allNode.Targets.empty()) {
+        allNode.Targets.insert("noop-products");
+        allTarget.Dependencies.push_back("noop");
+      }
 
-    allTarget.AliasNodes.push_back(allNode);
-    GetGlobalFastbuildGenerator()->AddTarget(allTarget);
+      allTarget.AliasNodes.push_back(std::move(allNode));
+      GetGlobalFastbuildGenerator()->AddTarget(std::move(allTarget));
+    }
   }
 }
 
 void cmLocalFastbuildGenerator::AddTarget(
-  const cmGlobalFastbuildGenerator::FastbuildTarget& target)
+  cmGlobalFastbuildGenerator::FastbuildTarget&& target)
 {
-  GetGlobalFastbuildGenerator()->AddTarget(target);
   if (!target.IsGlobal && !target.IsExcluded) {
-    AllTargets[cmSystemTools::GetFilenamePath(target.Name)].push_back(
-      target.Name);
+    AllTargets[{ cmSystemTools::GetFilenamePath(target.Name), target.Config }]
+      .push_back(target.Name);
   }
+  GetGlobalFastbuildGenerator()->AddTarget(std::move(target));
 }
 
 const cmGlobalFastbuildGenerator*
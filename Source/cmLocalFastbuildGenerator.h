@@ -39,10 +39,12 @@ public:
   const cmGlobalFastbuildGenerator* GetGlobalFastbuildGenerator() const;
   cmGlobalFastbuildGenerator* GetGlobalFastbuildGenerator();
 
-  void AddTarget(const cmGlobalFastbuildGenerator::FastbuildTarget& target);
+  void AddTarget(cmGlobalFastbuildGenerator::FastbuildTarget&& target);
 
 private:
-  std::map<std::string, std::vector<std::string>> AllTargets;
+  /// Targets of each directory and configuration, for its "all" alias.
+  std::map<std::pair<std::string, std::string>, std::vector<std::string>>
+    AllTargets;
 };
 
 #endif
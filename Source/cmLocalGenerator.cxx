@@ -2864,7 +2864,7 @@ std::vector<std::string> cmLocalGenerator::AddUnityFilesModeAuto(
     chunk = std::min(itemsLeft, batchSize);
 
     std::string filename = cmStrCat(filename_base, "unity_", batch,
-                                    (lang == "C") ? "_c.c" : "_cxx.cxx");
+                                    GetUnitySourceSuffix(lang));
 
     const std::string filename_tmp = cmStrCat(filename, ".tmp");
     {
@@ -2916,7 +2916,7 @@ std::vector<std::string> cmLocalGenerator::AddUnityFilesModeGroup(
   for (auto const& item : explicit_mapping) {
     auto const& name = item.first;
     std::string filename = cmStrCat(filename_base, "unity_", name,
-                                    (lang == "C") ? "_c.c" : "_cxx.cxx");
+                                    GetUnitySourceSuffix(lang));
 
     const std::string filename_tmp = cmStrCat(filename, ".tmp");
     {
@@ -2938,6 +2938,23 @@ std::vector<std::string> cmLocalGenerator::AddUnityFilesModeGroup(
   return unity_files;
 }
 
+std::string cmLocalGenerator::GetUnitySourceSuffix(std::string const& lang)
+{
+  if (lang == "C") {
+    return "_c.c";
+  }
+  if (lang == "OBJC") {
+    return "_m.m";
+  }
+  if (lang == "OBJCXX") {
+    return "_mm.mm";
+  }
+  if (lang == "CUDA") {
+    return "_cu.cu";
+  }
+  return "_cxx.cxx";
+}
+
 void cmLocalGenerator::AddUnityBuild(cmGeneratorTarget* target)
 {
   if (!target->GetPropertyAsBool("UNITY_BUILD")) {
@@ -2968,7 +2985,7 @@ void cmLocalGenerator::AddUnityBuild(cmGeneratorTarget* target)
   cmValue afterInclude = target->GetProperty("UNITY_BUILD_CODE_AFTER_INCLUDE");
   cmValue unityMode = target->GetProperty("UNITY_BUILD_MODE");
 
-  for (std::string lang : { "C", "CXX" }) {
+  for (std::string lang : { "C", "CXX", "OBJC", "OBJCXX", "CUDA" }) {
     std::vector<cmSourceFile*> filtered_sources;
     std::copy_if(sources.begin(), sources.end(),
                  std::back_inserter(filtered_sources), [&](cmSourceFile* sf) {
@@ -164,6 +164,8 @@ public:
   void AddISPCDependencies(cmGeneratorTarget* target);
   void AddPchDependencies(cmGeneratorTarget* target);
   void AddUnityBuild(cmGeneratorTarget* target);
+  /// Suffix of the unity sources of @a lang, like "_cxx.cxx".
+  static std::string GetUnitySourceSuffix(std::string const& lang);
   void AppendIPOLinkerFlags(std::string& flags, cmGeneratorTarget* target,
                             const std::string& config,
                             const std::string& lang);
@@ -47,6 +47,7 @@
 #include "cmLocalGenerator.h"
 #include "cmMessageType.h"
 #include "cmRange.h"
+#include "cmRegularExpressionCache.h"
 #include "cmSourceFile.h"
 #include "cmSourceFileLocation.h"
 #include "cmState.h"
@@ -594,13 +595,13 @@ bool cmMakefile::ReadDependentFile(const std::string& filename,
 
   IncludeScope incScope(this, filenametoread, noPolicyScope);
 
-  cmListFile listFile;
-  if (!listFile.ParseFile(filenametoread.c_str(), this->GetMessenger(),
-                          this->Backtrace)) {
+  std::shared_ptr<cmListFile const> listFile =
+    this->ParseListFile(filenametoread);
+  if (!listFile) {
     return false;
   }
 
-  this->RunListFile(listFile, filenametoread);
+  this->RunListFile(*listFile, filenametoread);
   if (cmSystemTools::GetFatalErrorOccured()) {
     incScope.Quiet();
   }
@@ -695,13 +696,13 @@ bool cmMakefile::ReadListFile(const std::string& filename)
 
   ListFileScope scope(this, filenametoread);
 
-  cmListFile listFile;
-  if (!listFile.ParseFile(filenametoread.c_str(), this->GetMessenger(),
-                          this->Backtrace)) {
+  std::shared_ptr<cmListFile const> listFile =
+    this->ParseListFile(filenametoread);
+  if (!listFile) {
     return false;
   }
 
-  this->RunListFile(listFile, filenametoread);
+  this->RunListFile(*listFile, filenametoread);
   if (cmSystemTools::GetFatalErrorOccured()) {
     scope.Quiet();
   }
@@ -729,6 +730,13 @@ bool cmMakefile::ReadListFileAsString(const std::string& content,
   return true;
 }
 
+std::shared_ptr<cmListFile const> cmMakefile::ParseListFile(
+  std::string const& filenametoread)
+{
+  cmListFileCache& cache = this->GetState()->GetListFileCache();
+  return cache.Parse(filenametoread, this->GetMessenger(), this->Backtrace);
+}
+
 void cmMakefile::RunListFile(cmListFile const& listFile,
                              std::string const& filenametoread,
                              DeferCommands* defer)
@@ -796,6 +804,23 @@ void cmMakefile::RunListFile(cmListFile const& listFile,
   this->MarkVariableAsUsed("CMAKE_PARENT_LIST_FILE");
   this->MarkVariableAsUsed("CMAKE_CURRENT_LIST_FILE");
   this->MarkVariableAsUsed("CMAKE_CURRENT_LIST_DIR");
+
+#if !defined(CMAKE_BOOTSTRAP)
+  // Report the caches once per list file rather than on every lookup.
+  if (this->GetCMakeInstance()->IsProfilingEnabled()) {
+    cmMakefileProfilingData& profiling =
+      this->GetCMakeInstance()->GetProfilingOutput();
+    cmListFileCache const& cache = this->GetState()->GetListFileCache();
+    profiling.CounterEntry(
+      "list file cache",
+      { { "hits", cache.GetHits() }, { "misses", cache.GetMisses() } });
+    cmRegularExpressionCache::Statistics const statistics =
+      cmRegularExpressionCache::GetStatistics();
+    profiling.CounterEntry(
+      "regular expression cache",
+      { { "hits", statistics.Hits }, { "misses", statistics.Misses } });
+  }
+#endif
 }
 
 void cmMakefile::EnforceDirectoryLevelRules() const
@@ -4360,10 +4385,15 @@ void cmMakefile::ClearMatches()
 }
 
 void cmMakefile::StoreMatches(cmsys::RegularExpression& re)
+{
+  this->StoreMatches(re.regMatch());
+}
+
+void cmMakefile::StoreMatches(cmsys::RegularExpressionMatch const& match)
 {
   char highest = 0;
   for (int i = 0; i < 10; i++) {
-    std::string const& m = re.match(i);
+    std::string const& m = match.match(i);
     if (!m.empty()) {
       std::string const& var = matchVariables[i];
       this->AddDefinition(var, m);
@@ -4376,6 +4406,12 @@ void cmMakefile::StoreMatches(cmsys::RegularExpression& re)
   this->MarkVariableAsUsed(nMatchesVariable);
 }
 
+std::shared_ptr<cmsys::RegularExpression const>
+cmMakefile::GetRegularExpression(std::string const& pattern) const
+{
+  return cmRegularExpressionCache::Get(pattern);
+}
+
 cmStateSnapshot cmMakefile::GetStateSnapshot() const
 {
   return this->StateSnapshot;
@@ -901,6 +901,14 @@ public:
 
   void ClearMatches();
   void StoreMatches(cmsys::RegularExpression& re);
+  void StoreMatches(cmsys::RegularExpressionMatch const& match);
+
+  /**
+   * Get the compiled @a pattern from the cmRegularExpressionCache, null if
+   * it does not compile.
+   */
+  std::shared_ptr<cmsys::RegularExpression const> GetRegularExpression(
+    std::string const& pattern) const;
 
   cmStateSnapshot GetStateSnapshot() const;
 
@@ -1017,6 +1025,8 @@ private:
 
   void DoGenerate(cmLocalGenerator& lg);
 
+  std::shared_ptr<cmListFile const> ParseListFile(
+    std::string const& filenametoread);
   void RunListFile(cmListFile const& listFile,
                    const std::string& filenametoread,
                    DeferCommands* defer = nullptr);
@@ -1,8 +1,12 @@
 /* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
    file Copyright.txt or https://cmake.org/licensing for details.  */
 #pragma once
+#include <cstddef>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "cmsys/FStream.hxx"
 
@@ -20,8 +24,14 @@ public:
   ~cmMakefileProfilingData() noexcept;
   void StartEntry(const cmListFileFunction& lff, cmListFileContext const& lfc);
   void StopEntry();
+  /// Record counter @a name, unless its values did not change.
+  void CounterEntry(
+    std::string const& name,
+    std::vector<std::pair<std::string, std::size_t>> const& values);
 
 private:
   cmsys::ofstream ProfileStream;
   std::unique_ptr<Json::StreamWriter> JsonWriter;
+  std::map<std::string, std::vector<std::pair<std::string, std::size_t>>>
+    Counters;
 };
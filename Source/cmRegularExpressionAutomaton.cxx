@@ -0,0 +1,482 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmRegularExpressionAutomaton.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+/*
+ * The parser accepts the syntax of cmsys::RegularExpression and rejects
+ * the same expressions, with the same messages.  It builds a tree of the
+ * expression first, because the operators *, + and ? follow their operand
+ * but their code comes before it.
+ */
+class cmRegularExpressionAutomaton::Parser
+{
+public:
+  Parser(char const* pattern, cmRegularExpressionAutomaton& re)
+    : Pattern(pattern)
+    , RE(re)
+  {
+  }
+
+  bool Parse()
+  {
+    Node root;
+    if (!this->ParseAlternatives(0, root)) {
+      return false;
+    }
+    this->Emit(Op::Save, 0);
+    this->Emit(root);
+    this->Emit(Op::Save, 1);
+    this->Emit(Op::Match);
+    return true;
+  }
+
+private:
+  enum class Kind
+  {
+    Char,
+    Any,
+    Class,
+    Bol,
+    Eol,
+    Group,
+    Concat,
+    Alternatives,
+    Star,
+    Plus,
+    Optional,
+  };
+
+  struct Node
+  {
+    Kind Type = Kind::Concat;
+    std::size_t Arg = 0;
+    std::vector<Node> Children;
+    // Whether the node always consumes input.
+    bool HasWidth = false;
+  };
+
+  static bool IsMulti(char c) { return c == '*' || c == '+' || c == '?'; }
+
+  bool Fail(char const* message)
+  {
+    this->RE.Error = message;
+    return false;
+  }
+
+  // The main body or a parenthesized expression, the caller consumed the
+  // opening parenthesis.
+  bool ParseAlternatives(int paren, Node& node)
+  {
+    int group = 0;
+    if (paren) {
+      if (this->Groups >= NumberOfSubmatches) {
+        return this->Fail("Too many parentheses.");
+      }
+      group = this->Groups++;
+    }
+
+    Node alternatives;
+    alternatives.Type = Kind::Alternatives;
+    alternatives.HasWidth = true;
+    for (;;) {
+      Node branch;
+      if (!this->ParseBranch(branch)) {
+        return false;
+      }
+      alternatives.HasWidth = alternatives.HasWidth && branch.HasWidth;
+      alternatives.Children.push_back(std::move(branch));
+      if (*this->Pattern != '|') {
+        break;
+      }
+      ++this->Pattern;
+    }
+
+    if (paren) {
+      if (*this->Pattern++ != ')') {
+        return this->Fail("Unmatched parentheses.");
+      }
+      node.Type = Kind::Group;
+      node.Arg = static_cast<std::size_t>(group);
+      node.HasWidth = alternatives.HasWidth;
+      node.Children.push_back(std::move(alternatives));
+    } else {
+      if (*this->Pattern != '\0') {
+        return this->Fail("Unmatched parentheses.");
+      }
+      node = std::move(alternatives);
+    }
+    return true;
+  }
+
+  // One alternative of an | operator.
+  bool ParseBranch(Node& branch)
+  {
+    branch.Type = Kind::Concat;
+    while (*this->Pattern != '\0' && *this->Pattern != '|' &&
+           *this->Pattern != ')') {
+      Node piece;
+      if (!this->ParsePiece(piece)) {
+        return false;
+      }
+      branch.HasWidth = branch.HasWidth || piece.HasWidth;
+      branch.Children.push_back(std::move(piece));
+    }
+    return true;
+  }
+
+  // An atom followed by a possible *, + or ?.
+  bool ParsePiece(Node& piece)
+  {
+    Node atom;
+    if (!this->ParseAtom(atom)) {
+      return false;
+    }
+
+    char const op = *this->Pattern;
+    if (!IsMulti(op)) {
+      piece = std::move(atom);
+      return true;
+    }
+    if (!atom.HasWidth && op != '?') {
+      return this->Fail("*+ operand could be empty.");
+    }
+    piece.Type =
+      op == '*' ? Kind::Star : (op == '+' ? Kind::Plus : Kind::Optional);
+    piece.HasWidth = op == '+';
+    piece.Children.push_back(std::move(atom));
+    if (IsMulti(*++this->Pattern)) {
+      return this->Fail("Nested *?+.");
+    }
+    return true;
+  }
+
+  bool ParseAtom(Node& atom)
+  {
+    char const c = *this->Pattern++;
+    switch (c) {
+      case '^':
+        atom.Type = Kind::Bol;
+        return true;
+      case '$':
+        atom.Type = Kind::Eol;
+        return true;
+      case '.':
+        atom.Type = Kind::Any;
+        atom.HasWidth = true;
+        return true;
+      case '[':
+        return this->ParseClass(atom);
+      case '(':
+        return this->ParseAlternatives(1, atom);
+      case '?':
+      case '+':
+      case '*':
+        return this->Fail("?+* follows nothing.");
+      case '\\':
+        if (*this->Pattern == '\0') {
+          return this->Fail("Trailing backslash.");
+        }
+        atom.Type = Kind::Char;
+        atom.Arg = static_cast<unsigned char>(*this->Pattern++);
+        atom.HasWidth = true;
+        return true;
+      default:
+        atom.Type = Kind::Char;
+        atom.Arg = static_cast<unsigned char>(c);
+        atom.HasWidth = true;
+        return true;
+    }
+  }
+
+  // A bracket expression, the caller consumed the opening bracket.
+  bool ParseClass(Node& atom)
+  {
+    bool const complement = *this->Pattern == '^';
+    if (complement) {
+      ++this->Pattern;
+    }
+    std::vector<bool> members(256, false);
+    auto const uc = [](char ch) { return static_cast<unsigned char>(ch); };
+    if (*this->Pattern == ']' || *this->Pattern == '-') {
+      members[uc(*this->Pattern++)] = true;
+    }
+    while (*this->Pattern != '\0' && *this->Pattern != ']') {
+      if (*this->Pattern != '-') {
+        members[uc(*this->Pattern++)] = true;
+        continue;
+      }
+      ++this->Pattern;
+      if (*this->Pattern == ']' || *this->Pattern == '\0') {
+        members['-'] = true;
+        continue;
+      }
+      // The range starts after the character before the dash, which is
+      // already a member.
+      int first = uc(this->Pattern[-2]) + 1;
+      int const last = uc(*this->Pattern++);
+      if (first > last + 1) {
+        return this->Fail("Invalid range in [].");
+      }
+      for (; first <= last; ++first) {
+        members[static_cast<std::size_t>(first)] = true;
+      }
+    }
+    if (*this->Pattern != ']') {
+      return this->Fail("Unmatched [].");
+    }
+    ++this->Pattern;
+
+    if (complement) {
+      members.flip();
+    }
+    // The end of the string is never a member.
+    members[0] = false;
+    atom.Type = Kind::Class;
+    atom.Arg = this->RE.Classes.size();
+    atom.HasWidth = true;
+    this->RE.Classes.push_back(std::move(members));
+    return true;
+  }
+
+  std::size_t Emit(Op code, std::size_t arg = 0, std::size_t alt = 0)
+  {
+    this->RE.Program.push_back({ code, arg, alt });
+    return this->RE.Program.size() - 1;
+  }
+
+  std::size_t Here() const { return this->RE.Program.size(); }
+
+  // Split and jump instructions are emitted before their targets are
+  // known and patched afterwards, the preferred way first.
+  void Emit(Node const& node)
+  {
+    auto& program = this->RE.Program;
+    switch (node.Type) {
+      case Kind::Char:
+        this->Emit(Op::Char, node.Arg);
+        break;
+      case Kind::Any:
+        this->Emit(Op::Any);
+        break;
+      case Kind::Class:
+        this->Emit(Op::Class, node.Arg);
+        break;
+      case Kind::Bol:
+        this->Emit(Op::Bol);
+        break;
+      case Kind::Eol:
+        this->Emit(Op::Eol);
+        break;
+      case Kind::Group:
+        this->Emit(Op::Save, 2 * node.Arg);
+        this->Emit(node.Children.front());
+        this->Emit(Op::Save, 2 * node.Arg + 1);
+        break;
+      case Kind::Concat:
+        for (Node const& child : node.Children) {
+          this->Emit(child);
+        }
+        break;
+      case Kind::Alternatives: {
+        std::vector<std::size_t> jumps;
+        for (std::size_t i = 0; i + 1 < node.Children.size(); ++i) {
+          std::size_t const split = this->Emit(Op::Split, this->Here() + 1);
+          this->Emit(node.Children[i]);
+          jumps.push_back(this->Emit(Op::Jump));
+          program[split].Alt = this->Here();
+        }
+        this->Emit(node.Children.back());
+        for (std::size_t jump : jumps) {
+          program[jump].Arg = this->Here();
+        }
+      } break;
+      case Kind::Star: {
+        // Prefer another repetition over leaving.
+        std::size_t const split = this->Emit(Op::Split, this->Here() + 1);
+        this->Emit(node.Children.front());
+        this->Emit(Op::Jump, split);
+        program[split].Alt = this->Here();
+      } break;
+      case Kind::Plus: {
+        std::size_t const start = this->Here();
+        this->Emit(node.Children.front());
+        this->Emit(Op::Split, start, this->Here() + 1);
+      } break;
+      case Kind::Optional: {
+        std::size_t const split = this->Emit(Op::Split, this->Here() + 1);
+        this->Emit(node.Children.front());
+        program[split].Alt = this->Here();
+      } break;
+    }
+  }
+
+  char const* Pattern;
+  cmRegularExpressionAutomaton& RE;
+  int Groups = 1;
+};
+
+cmRegularExpressionAutomaton::cmRegularExpressionAutomaton(
+  std::string const& pattern)
+{
+  this->Compile(pattern);
+}
+
+bool cmRegularExpressionAutomaton::Compile(std::string const& pattern)
+{
+  this->Program.clear();
+  this->Classes.clear();
+  this->Error.clear();
+  this->SearchString = nullptr;
+
+  Parser parser(pattern.c_str(), *this);
+  if (!parser.Parse()) {
+    this->Program.clear();
+    this->Classes.clear();
+    return false;
+  }
+  this->Visited.assign(this->Program.size(), 0);
+  this->Step = 0;
+  return true;
+}
+
+/*
+ * Follow the instructions from pc that consume no input and add the
+ * consuming ones reached to list, the preferred ones first.  An
+ * instruction visited before in the same step is reached by a preferred
+ * thread already, whose future is the same, so each instruction is visited
+ * at most once per step and a search is linear in the length of the input.
+ */
+void cmRegularExpressionAutomaton::AddThread(std::vector<Thread>& list,
+                                             std::size_t pc,
+                                             char const* input, Thread& t)
+{
+  if (this->Visited[pc] == this->Step) {
+    return;
+  }
+  this->Visited[pc] = this->Step;
+
+  Instruction const& in = this->Program[pc];
+  switch (in.Code) {
+    case Op::Bol:
+      if (input == this->SearchString) {
+        this->AddThread(list, pc + 1, input, t);
+      }
+      break;
+    case Op::Eol:
+      if (*input == '\0') {
+        this->AddThread(list, pc + 1, input, t);
+      }
+      break;
+    case Op::Save: {
+      char const* const saved = t.Submatches[in.Arg];
+      t.Submatches[in.Arg] = input;
+      this->AddThread(list, pc + 1, input, t);
+      t.Submatches[in.Arg] = saved;
+    } break;
+    case Op::Split:
+      this->AddThread(list, in.Arg, input, t);
+      this->AddThread(list, in.Alt, input, t);
+      break;
+    case Op::Jump:
+      this->AddThread(list, in.Arg, input, t);
+      break;
+    case Op::Char:
+    case Op::Any:
+    case Op::Class:
+    case Op::Match:
+      t.PC = pc;
+      list.push_back(t);
+      break;
+  }
+}
+
+bool cmRegularExpressionAutomaton::Find(char const* string)
+{
+  for (char const*& submatch : this->Submatches) {
+    submatch = nullptr;
+  }
+  this->SearchString = string;
+  if (!this->IsValid()) {
+    return false;
+  }
+
+  Thread start;
+  for (char const*& submatch : start.Submatches) {
+    submatch = nullptr;
+  }
+
+  bool matched = false;
+  char const* s = string;
+  this->Current.clear();
+  ++this->Step;
+  this->AddThread(this->Current, 0, s, start);
+  for (;;) {
+    char const c = *s;
+    ++this->Step;
+    this->Next.clear();
+    for (Thread& t : this->Current) {
+      Instruction const& in = this->Program[t.PC];
+      if (in.Code == Op::Match) {
+        // The threads after this one are less preferred.
+        std::copy(std::begin(t.Submatches), std::end(t.Submatches),
+                  std::begin(this->Submatches));
+        matched = true;
+        break;
+      }
+      if (c == '\0') {
+        continue;
+      }
+      if ((in.Code == Op::Char && static_cast<unsigned char>(c) == in.Arg) ||
+          in.Code == Op::Any ||
+          (in.Code == Op::Class &&
+           this->Classes[in.Arg][static_cast<unsigned char>(c)])) {
+        this->AddThread(this->Next, t.PC + 1, s + 1, t);
+      }
+    }
+    if (c == '\0') {
+      break;
+    }
+    ++s;
+
+    // A match starting here is less preferred than all earlier ones.
+    if (!matched) {
+      this->AddThread(this->Next, 0, s, start);
+    }
+    std::swap(this->Current, this->Next);
+    if (matched && this->Current.empty()) {
+      break;
+    }
+  }
+  return matched;
+}
+
+std::string::size_type cmRegularExpressionAutomaton::GetStart(int n) const
+{
+  char const* start = this->Submatches[2 * n];
+  if (!start || !this->Submatches[2 * n + 1]) {
+    return std::string::npos;
+  }
+  return static_cast<std::string::size_type>(start - this->SearchString);
+}
+
+std::string::size_type cmRegularExpressionAutomaton::GetEnd(int n) const
+{
+  char const* end = this->Submatches[2 * n + 1];
+  if (!this->Submatches[2 * n] || !end) {
+    return std::string::npos;
+  }
+  return static_cast<std::string::size_type>(end - this->SearchString);
+}
+
+std::string cmRegularExpressionAutomaton::GetMatch(int n) const
+{
+  std::string::size_type const start = this->GetStart(n);
+  if (start == std::string::npos) {
+    return std::string();
+  }
+  return std::string(this->SearchString + start, this->GetEnd(n) - start);
+}
@@ -0,0 +1,100 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/** \class cmRegularExpressionAutomaton
+ * \brief A regular expression matched in time linear in the input.
+ *
+ * The syntax and the matches are those of cmsys::RegularExpression, which
+ * backtracks and takes exponential time on some expressions, like
+ * "(a|aa)*c$" on a long run of "a" followed by "cx".  This class compiles
+ * the expression into a program run as a Thompson NFA (a Pike VM) instead:
+ * all alternatives advance together, one character at a time.  Threads are
+ * kept in the order the backtracking engine would try them, so the first
+ * thread to match gives the same match and submatches.
+ *
+ * Short expressions on short strings are faster with backtracking, this
+ * is meant for expressions applied to long or untrusted input, like the
+ * rules CTest applies to every line of build output.
+ */
+class cmRegularExpressionAutomaton
+{
+public:
+  /// Number of submatches, the whole match included.
+  static constexpr int NumberOfSubmatches = 10;
+
+  cmRegularExpressionAutomaton() = default;
+  explicit cmRegularExpressionAutomaton(std::string const& pattern);
+
+  /// Compile @a pattern, false if it is not a valid expression.
+  bool Compile(std::string const& pattern);
+
+  bool IsValid() const { return !this->Program.empty(); }
+
+  /// The reason the last Compile failed.
+  std::string const& GetError() const { return this->Error; }
+
+  /// Find the first match in @a string and keep its submatches.
+  bool Find(char const* string);
+  bool Find(std::string const& string) { return this->Find(string.c_str()); }
+
+  /// Offsets of the @a n th submatch of the last Find, std::string::npos
+  /// if it did not participate in the match.
+  std::string::size_type GetStart(int n = 0) const;
+  std::string::size_type GetEnd(int n = 0) const;
+
+  /// The @a n th submatch of the last Find, empty if it did not match.
+  std::string GetMatch(int n = 0) const;
+
+private:
+  enum class Op
+  {
+    Char,  // Consume Arg.
+    Any,   // Consume any character.
+    Class, // Consume a character of Classes[Arg].
+    Bol,   // Match at the beginning of the string.
+    Eol,   // Match at the end of the string.
+    Save,  // Record the position as submatch boundary Arg.
+    Split, // Continue at Arg, then at Alt.
+    Jump,  // Continue at Arg.
+    Match,
+  };
+
+  struct Instruction
+  {
+    Op Code;
+    std::size_t Arg;
+    std::size_t Alt;
+  };
+
+  struct Thread
+  {
+    std::size_t PC;
+    char const* Submatches[2 * NumberOfSubmatches];
+  };
+
+  class Parser;
+
+  void AddThread(std::vector<Thread>& list, std::size_t pc,
+                 char const* input, Thread& t);
+
+  std::vector<Instruction> Program;
+  std::vector<std::vector<bool>> Classes;
+  std::string Error;
+
+  // State of the last Find.
+  char const* SearchString = nullptr;
+  char const* Submatches[2 * NumberOfSubmatches] = {};
+
+  // Scratch space of Find, kept to avoid allocating for every string.
+  std::vector<Thread> Current;
+  std::vector<Thread> Next;
+  std::vector<std::size_t> Visited;
+  std::size_t Step = 0;
+};
@@ -0,0 +1,69 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmRegularExpressionCache.h"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+struct Cache
+{
+  using Entry =
+    std::pair<std::string, std::shared_ptr<cmsys::RegularExpression const>>;
+
+  std::mutex Mutex;
+  // Most recently used first.
+  std::list<Entry> Entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> Index;
+  cmRegularExpressionCache::Statistics Statistics;
+};
+
+Cache& GetCache()
+{
+  static Cache cache;
+  return cache;
+}
+}
+
+std::shared_ptr<cmsys::RegularExpression const> cmRegularExpressionCache::Get(
+  std::string const& pattern)
+{
+  Cache& cache = GetCache();
+  {
+    std::lock_guard<std::mutex> lock(cache.Mutex);
+    auto it = cache.Index.find(pattern);
+    if (it != cache.Index.end()) {
+      ++cache.Statistics.Hits;
+      cache.Entries.splice(cache.Entries.begin(), cache.Entries, it->second);
+      return it->second->second;
+    }
+    ++cache.Statistics.Misses;
+  }
+
+  // Patterns that do not compile are not kept, compiling them again
+  // reports the error again.
+  auto regex = std::make_shared<cmsys::RegularExpression>();
+  if (!regex->compile(pattern)) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(cache.Mutex);
+  if (cache.Index.find(pattern) == cache.Index.end()) {
+    cache.Entries.emplace_front(pattern, regex);
+    cache.Index.emplace(pattern, cache.Entries.begin());
+    if (cache.Entries.size() > Capacity) {
+      cache.Index.erase(cache.Entries.back().first);
+      cache.Entries.pop_back();
+    }
+  }
+  return regex;
+}
+
+cmRegularExpressionCache::Statistics cmRegularExpressionCache::GetStatistics()
+{
+  Cache& cache = GetCache();
+  std::lock_guard<std::mutex> lock(cache.Mutex);
+  return cache.Statistics;
+}
@@ -0,0 +1,39 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "cmsys/RegularExpression.hxx"
+
+/** \class cmRegularExpressionCache
+ * \brief Compiled regular expressions shared by the commands of a process.
+ *
+ * Commands like string(REGEX) and if(MATCHES) mostly match the same few
+ * literal patterns, often in loops.  The cache keeps the most recently
+ * used expressions compiled.  The expressions are shared and must not be
+ * modified, so callers keep the result of a match in their own
+ * cmsys::RegularExpressionMatch.
+ */
+class cmRegularExpressionCache
+{
+public:
+  /// Number of expressions kept before the least recently used is dropped.
+  static constexpr std::size_t Capacity = 1024;
+
+  /// The compiled @a pattern, null if it does not compile.
+  static std::shared_ptr<cmsys::RegularExpression const> Get(
+    std::string const& pattern);
+
+  struct Statistics
+  {
+    std::size_t Hits = 0;
+    std::size_t Misses = 0;
+  };
+
+  static Statistics GetStatistics();
+};
@@ -219,6 +219,9 @@ public:
 
   ProjectKind GetProjectKind() const;
 
+  //! Parsed list files shared by every read of a file.
+  cmListFileCache& GetListFileCache() { return this->ListFileCache; }
+
 private:
   friend class cmake;
   void AddCacheEntry(const std::string& key, const char* value,
@@ -256,6 +259,7 @@ private:
   cmPropertyMap GlobalProperties;
   std::unique_ptr<cmCacheManager> CacheManager;
   std::unique_ptr<cmGlobVerificationManager> GlobVerificationManager;
+  cmListFileCache ListFileCache;
 
   cmLinkedTree<cmStateDetail::BuildsystemDirectoryStateType>
     BuildsystemDirectory;
@@ -240,8 +240,8 @@ bool RegexMatch(std::vector<std::string> const& args,
 
   status.GetMakefile().ClearMatches();
   // Compile the regular expression.
-  cmsys::RegularExpression re;
-  if (!re.compile(regex)) {
+  auto re = status.GetMakefile().GetRegularExpression(regex);
+  if (!re) {
     std::string e =
       "sub-command REGEX, mode MATCH failed to compile regex \"" + regex +
       "\".";
@@ -254,10 +254,11 @@ bool RegexMatch(std::vector<std::string> const& args,
 
   // Scan through the input for all matches.
   std::string output;
-  if (re.find(input)) {
-    status.GetMakefile().StoreMatches(re);
-    std::string::size_type l = re.start();
-    std::string::size_type r = re.end();
+  cmsys::RegularExpressionMatch match;
+  if (re->find(input.c_str(), match)) {
+    status.GetMakefile().StoreMatches(match);
+    std::string::size_type l = match.start();
+    std::string::size_type r = match.end();
     if (r - l == 0) {
       std::string e = "sub-command REGEX, mode MATCH regex \"" + regex +
         "\" matched an empty string.";
@@ -282,8 +283,8 @@ bool RegexMatchAll(std::vector<std::string> const& args,
 
   status.GetMakefile().ClearMatches();
   // Compile the regular expression.
-  cmsys::RegularExpression re;
-  if (!re.compile(regex)) {
+  auto re = status.GetMakefile().GetRegularExpression(regex);
+  if (!re) {
     std::string e =
       "sub-command REGEX, mode MATCHALL failed to compile regex \"" + regex +
       "\".";
@@ -297,11 +298,12 @@ bool RegexMatchAll(std::vector<std::string> const& args,
   // Scan through the input for all matches.
   std::string output;
   const char* p = input.c_str();
-  while (re.find(p)) {
+  cmsys::RegularExpressionMatch match;
+  while (re->find(p, match)) {
     status.GetMakefile().ClearMatches();
-    status.GetMakefile().StoreMatches(re);
-    std::string::size_type l = re.start();
-    std::string::size_type r = re.end();
+    status.GetMakefile().StoreMatches(match);
+    std::string::size_type l = match.start();
+    std::string::size_type r = match.end();
     if (r - l == 0) {
       std::string e = "sub-command REGEX, mode MATCHALL regex \"" + regex +
         "\" matched an empty string.";
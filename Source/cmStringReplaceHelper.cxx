@@ -7,12 +7,14 @@
 #include <utility>
 
 #include "cmMakefile.h"
+#include "cmRegularExpressionCache.h"
 
 cmStringReplaceHelper::cmStringReplaceHelper(const std::string& regex,
                                              std::string replace_expr,
                                              cmMakefile* makefile)
   : RegExString(regex)
-  , RegularExpression(regex)
+  , RegularExpression(makefile ? makefile->GetRegularExpression(regex)
+                               : cmRegularExpressionCache::Get(regex))
   , ReplaceExpression(std::move(replace_expr))
   , Makefile(makefile)
 {
@@ -26,13 +28,13 @@ bool cmStringReplaceHelper::Replace(const std::string& input,
 
   // Scan through the input for all matches.
   std::string::size_type base = 0;
-  while (this->RegularExpression.find(input.c_str() + base)) {
+  while (this->RegularExpression->find(input.c_str() + base, this->Match)) {
     if (this->Makefile != nullptr) {
       this->Makefile->ClearMatches();
-      this->Makefile->StoreMatches(this->RegularExpression);
+      this->Makefile->StoreMatches(this->Match);
     }
-    auto l2 = this->RegularExpression.start();
-    auto r = this->RegularExpression.end();
+    auto l2 = this->Match.start();
+    auto r = this->Match.end();
 
     // Concatenate the part of the input that was not matched.
     output += input.substr(base, l2);
@@ -53,8 +55,8 @@ bool cmStringReplaceHelper::Replace(const std::string& input,
       } else {
         // Replace with part of the match.
         auto n = replacement.Number;
-        auto start = this->RegularExpression.start(n);
-        auto end = this->RegularExpression.end(n);
+        auto start = this->Match.start(n);
+        auto end = this->Match.end(n);
         auto len = input.length() - base;
         if ((start != std::string::npos) && (end != std::string::npos) &&
             (start <= len) && (end <= len)) {
@@ -16,6 +16,7 @@
 
 #include "cmGccDepfileReader.h"
 #include "cmGccDepfileReaderTypes.h"
+#include "cmGeneratedFileStream.h"
 #include "cmGlobalGenerator.h"
 #include "cmLocalGenerator.h"
 #include "cmSystemTools.h"
@@ -106,6 +107,36 @@ void WriteMSBuildAdditionalInputs(cmsys::ofstream& fout,
   }
   fout << "\n";
 }
+
+void WriteFastbuildExecInput(cmsys::ofstream& fout,
+                             cmLocalGenerator const& lg,
+                             cmGccDepfileContent const& content)
+{
+  // The fragment is included in the body of the Exec node.
+  fout << "// Dependencies discovered by the last run of the command\n";
+  const char* sep = ".ExecInput + {\n";
+  for (auto const& dep : content) {
+    for (std::string path : dep.paths) {
+      if (!cmSystemTools::FileIsFullPath(path)) {
+        path = cmSystemTools::CollapseFullPath(path,
+                                               lg.GetCurrentBinaryDirectory());
+      }
+      fout << sep << "  '";
+      for (auto c : path) {
+        if (c == '^' || c == '$' || c == '\'') {
+          fout << '^';
+        }
+        fout << c;
+      }
+      fout << '\'';
+      sep = ",\n";
+    }
+  }
+  if (*sep == ',') {
+    fout << "\n}\n"
+            ".ExecAlways = false\n";
+  }
+}
 }
 
 bool cmTransformDepfile(cmDepfileFormat format, const cmLocalGenerator& lg,
@@ -122,10 +153,12 @@ bool cmTransformDepfile(cmDepfileFormat format, const cmLocalGenerator& lg,
   }
 
   cmSystemTools::MakeDirectory(cmSystemTools::GetFilenamePath(outfile));
-  cmsys::ofstream fout(outfile.c_str());
+  cmGeneratedFileStream fout(outfile);
   if (!fout) {
     return false;
   }
+  // Fastbuild parses its configuration again when the fragment changes.
+  fout.SetCopyIfDifferent(format == cmDepfileFormat::FastbuildExecInput);
   switch (format) {
     case cmDepfileFormat::GccDepfile:
     case cmDepfileFormat::MakeDepfile:
@@ -134,6 +167,9 @@ bool cmTransformDepfile(cmDepfileFormat format, const cmLocalGenerator& lg,
     case cmDepfileFormat::MSBuildAdditionalInputs:
       WriteMSBuildAdditionalInputs(fout, lg, content);
       break;
+    case cmDepfileFormat::FastbuildExecInput:
+      WriteFastbuildExecInput(fout, lg, content);
+      break;
   }
   return true;
 }
@@ -9,6 +9,7 @@ enum class cmDepfileFormat
   GccDepfile,
   MakeDepfile,
   MSBuildAdditionalInputs,
+  FastbuildExecInput,
 };
 
 class cmLocalGenerator;
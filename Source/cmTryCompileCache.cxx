@@ -0,0 +1,102 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#include "cmTryCompileCache.h"
+
+#include <iterator>
+#include <utility>
+
+#include "cmsys/FStream.hxx"
+
+#include "cmStringAlgorithms.h"
+#include "cmSystemTools.h"
+
+// An entry is a "<key>.result" file holding the result code, whether the
+// entry has a built file, and the output, and a "<key>.file" file holding
+// the built file.  The result file is renamed in place last.
+
+cmTryCompileCache::cmTryCompileCache(std::string directory)
+  : Directory(std::move(directory))
+{
+}
+
+std::string cmTryCompileCache::GetEntryPath(std::string const& key) const
+{
+  // Spread the entries over subdirectories named by their first two hex
+  // digits, as a directory with thousands of files is slow on some
+  // filesystems.
+  return cmStrCat(this->Directory, '/', key.substr(0, 2), '/', key);
+}
+
+cm::optional<cmTryCompileCache::Entry> cmTryCompileCache::Load(
+  std::string const& key) const
+{
+  std::string const path = this->GetEntryPath(key);
+  cmsys::ifstream fin(cmStrCat(path, ".result").c_str(),
+                      std::ios::in | std::ios::binary);
+  if (!fin) {
+    return cm::nullopt;
+  }
+
+  Entry entry;
+  int hasFile = 0;
+  if (!(fin >> entry.Result >> hasFile) || fin.get() != '\n') {
+    return cm::nullopt;
+  }
+  entry.Output.assign(std::istreambuf_iterator<char>(fin),
+                      std::istreambuf_iterator<char>());
+  if (hasFile) {
+    entry.OutputFile = cmStrCat(path, ".file");
+    if (!cmSystemTools::FileExists(entry.OutputFile, true)) {
+      return cm::nullopt;
+    }
+  }
+  return cm::make_optional(std::move(entry));
+}
+
+bool cmTryCompileCache::Store(std::string const& key, int result,
+                              std::string const& output,
+                              std::string const& outputFile) const
+{
+  std::string const path = this->GetEntryPath(key);
+  if (!cmSystemTools::MakeDirectory(cmSystemTools::GetFilenamePath(path))) {
+    return false;
+  }
+  std::string const tmp =
+    cmStrCat(path, ".tmp", cmSystemTools::RandomSeed() & 0xFFFFF);
+
+  if (!outputFile.empty()) {
+    if (!cmSystemTools::CopyFileAlways(outputFile, tmp) ||
+        cmSystemTools::RenameFile(tmp, cmStrCat(path, ".file"),
+                                  cmSystemTools::Replace::Yes) !=
+          cmSystemTools::RenameResult::Success) {
+      cmSystemTools::RemoveFile(tmp);
+      return false;
+    }
+  }
+
+  {
+    cmsys::ofstream fout(tmp.c_str(), std::ios::out | std::ios::binary);
+    fout << result << ' ' << (outputFile.empty() ? 0 : 1) << '\n' << output;
+    if (!fout) {
+      fout.close();
+      cmSystemTools::RemoveFile(tmp);
+      return false;
+    }
+  }
+  if (cmSystemTools::RenameFile(tmp, cmStrCat(path, ".result"),
+                                cmSystemTools::Replace::Yes) !=
+      cmSystemTools::RenameResult::Success) {
+    cmSystemTools::RemoveFile(tmp);
+    return false;
+  }
+  return true;
+}
+
+void cmTryCompileCache::Remove(std::string const& key) const
+{
+  // Remove the result file first so the entry is never seen without its
+  // built file.
+  std::string const path = this->GetEntryPath(key);
+  cmSystemTools::RemoveFile(cmStrCat(path, ".result"));
+  cmSystemTools::RemoveFile(cmStrCat(path, ".file"));
+}
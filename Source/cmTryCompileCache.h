@@ -0,0 +1,54 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+#pragma once
+
+#include "cmConfigure.h" // IWYU pragma: keep
+
+#include <string>
+
+#include <cm/optional>
+
+/** \class cmTryCompileCache
+ * \brief Results of try_compile shared by build trees.
+ *
+ * When CMAKE_TRY_COMPILE_CACHE_DIR is set, try_compile and try_run with
+ * the source file signature keep their successful results, with their
+ * output and built file, in that directory, under a key hashed from
+ * everything the test project is built from.  A fresh build tree with the same toolchain reuses them
+ * instead of building the test project again.
+ *
+ * The files of an entry are written under temporary names and renamed in
+ * place, so build trees configured concurrently may share the directory.
+ */
+class cmTryCompileCache
+{
+public:
+  cmTryCompileCache(std::string directory);
+
+  struct Entry
+  {
+    int Result = 1;
+    std::string Output;
+    /** Full path of the file built by the test project, empty if none.  */
+    std::string OutputFile;
+  };
+
+  /** The entry stored under @a key, if any.  */
+  cm::optional<Entry> Load(std::string const& key) const;
+
+  /**
+   * Store the @a result and @a output of a test project under @a key,
+   * replacing any entry stored before.  If not empty, @a outputFile is
+   * copied into the entry.
+   */
+  bool Store(std::string const& key, int result, std::string const& output,
+             std::string const& outputFile) const;
+
+  /** Remove the entry stored under @a key, if any.  */
+  void Remove(std::string const& key) const;
+
+private:
+  std::string GetEntryPath(std::string const& key) const;
+
+  std::string Directory;
+};
@@ -2533,6 +2533,7 @@ void cmake::AddDefaultGenerators()
   this->Generators.push_back(cmGlobalNinjaGenerator::NewFactory());
   this->Generators.push_back(cmGlobalNinjaMultiGenerator::NewFactory());
   this->Generators.push_back(cmGlobalFastbuildGenerator::NewFactory());
+  this->Generators.push_back(cmGlobalFastbuildMultiGenerator::NewFactory());
 #elif defined(CMAKE_BOOTSTRAP_NINJA)
   this->Generators.push_back(cmGlobalNinjaGenerator::NewFactory());
 #elif defined(CMAKE_BOOTSTRAP_MAKEFILES)
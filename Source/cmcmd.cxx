@@ -29,6 +29,8 @@
 
 #if !defined(CMAKE_BOOTSTRAP)
 #  include "cmDependsFortran.h" // For -E cmake_copy_f90_mod callback.
+#  include "cmFastbuildModules.h"
+#  include "cmFastbuildProfile.h"
 #  include "cmFileTime.h"
 
 #  include "bindexplib.h"
@@ -114,6 +116,11 @@ void CMakeCommandUsage(std::string const& program)
     << "  env [--unset=NAME]... [NAME=VALUE]... COMMAND [ARG]...\n"
     << "                            - run command in a modified environment\n"
     << "  environment               - display the current environment\n"
+#ifndef CMAKE_BOOTSTRAP
+    << "  fastbuild_profile <profile.json> [<build-dir>]\n"
+    << "                            - summarize a FASTBuild profile per "
+       "target\n"
+#endif
     << "  make_directory <dir>...   - create parent and <dir> directories\n"
     << "  md5sum <file>...          - create MD5 checksum of files\n"
     << "  sha1sum <file>...         - create SHA1 checksum of files\n"
@@ -1307,6 +1314,20 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string> const& args,
     if (args[1] == "cmake_ninja_dyndep") {
       return cmcmd_cmake_ninja_dyndep(args.begin() + 2, args.end());
     }
+
+    // Attribute the jobs of "fbuild -profile" to the CMake targets.
+    if (args[1] == "fastbuild_profile" && args.size() >= 3 &&
+        args.size() <= 4) {
+      std::string const buildDir = args.size() == 4
+        ? args[3]
+        : cmSystemTools::GetCurrentWorkingDirectory();
+      return cmFastbuildProfile::Run(args[2], buildDir);
+    }
+
+    // Internal Fastbuild module collation
+    if (args[1] == "cmake_fastbuild_collate" && args.size() == 3) {
+      return cmFastbuildModules::Run(args[2]);
+    }
 #endif
 
     // Internal CMake unimplemented feature notification.
@@ -1533,6 +1554,8 @@ int cmcmd::ExecuteCMakeCommand(std::vector<std::string> const& args,
         format = cmDepfileFormat::MakeDepfile;
       } else if (args[3] == "MSBuildAdditionalInputs") {
         format = cmDepfileFormat::MSBuildAdditionalInputs;
+      } else if (args[3] == "FastbuildExecInput") {
+        format = cmDepfileFormat::FastbuildExecInput;
       } else {
         return 1;
       }
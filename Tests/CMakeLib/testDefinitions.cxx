@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cmDefinitions.h"
+#include "cmLinkedTree.h"
+#include "cmStringAlgorithms.h"
+#include "cmValue.h"
+
+namespace {
+
+using Tree = cmLinkedTree<cmDefinitions>;
+
+#define ASSERT_TRUE(x)                                                        \
+  do {                                                                        \
+    if (!(x)) {                                                               \
+      std::cout << "ASSERT_TRUE(" #x ") failed on line " << __LINE__ << "\n"; \
+      return false;                                                           \
+    }                                                                         \
+  } while (false)
+
+bool IsValue(cmValue value, std::string const& expected)
+{
+  return value && *value == expected;
+}
+
+bool testScopes()
+{
+  std::cout << "testScopes()" << std::endl;
+
+  // A directory scope with a function scope on top of it.
+  Tree tree;
+  Tree::iterator root = tree.Root();
+  Tree::iterator dir = tree.Push(root);
+  dir->Set("A", "dir");
+  dir->Set("B", "dir");
+  dir->Unset("C");
+  Tree::iterator fun = tree.Push(dir);
+  fun->Set("B", "fun");
+  fun->Unset("A");
+
+  ASSERT_TRUE(!cmDefinitions::Get("A", fun, root));
+  ASSERT_TRUE(IsValue(cmDefinitions::Get("B", fun, root), "fun"));
+  ASSERT_TRUE(IsValue(cmDefinitions::Get("B", dir, root), "dir"));
+  ASSERT_TRUE(IsValue(cmDefinitions::Get("A", dir, root), "dir"));
+  ASSERT_TRUE(cmDefinitions::HasKey("C", fun, root));
+  ASSERT_TRUE(!cmDefinitions::HasKey("D", fun, root));
+
+  // Raising localizes set and unset variables alike.
+  Tree::iterator inner = tree.Push(fun);
+  cmDefinitions::Raise("B", inner, root);
+  cmDefinitions::Raise("C", inner, root);
+  ASSERT_TRUE(cmDefinitions::HasKey("B", inner, fun));
+  ASSERT_TRUE(cmDefinitions::HasKey("C", inner, fun));
+  fun->Set("B", "changed");
+  ASSERT_TRUE(IsValue(cmDefinitions::Get("B", inner, root), "fun"));
+  ASSERT_TRUE(!cmDefinitions::Get("C", inner, root));
+
+  std::vector<std::string> keys = cmDefinitions::ClosureKeys(fun, root);
+  std::sort(keys.begin(), keys.end());
+  ASSERT_TRUE(keys == std::vector<std::string>{ "B" });
+  return true;
+}
+
+bool testClosure()
+{
+  std::cout << "testClosure()" << std::endl;
+
+  // Enough variables for several levels of the trie.
+  Tree tree;
+  Tree::iterator root = tree.Root();
+  Tree::iterator dir = tree.Push(root);
+  for (int i = 0; i < 5000; ++i) {
+    dir->Set(cmStrCat("V", i), std::to_string(i));
+  }
+  dir->Unset("V1");
+  Tree::iterator fun = tree.Push(dir);
+  fun->Set("V2", "fun");
+  fun->Unset("V3");
+  fun->Set("F", "fun");
+
+  // The closure shares the tables but must not see later changes, nor
+  // may its own changes leak into the scopes it was made from.
+  Tree::iterator sub = tree.Push(dir);
+  *sub = cmDefinitions::MakeClosure(fun, root);
+  dir->Set("V4", "changed");
+  dir->Unset("V5");
+  dir->Set("N", "new");
+  sub->Set("V6", "sub");
+  sub->Unset("V7");
+
+  ASSERT_TRUE(!cmDefinitions::HasKey("V1", sub, dir));
+  ASSERT_TRUE(IsValue(cmDefinitions::Get("V2", sub, dir), "fun"));
+  ASSERT_TRUE(!cmDefinitions::HasKey("V3", sub, dir));
+  ASSERT_TRUE(IsValue(cmDefinitions::Get("V4", sub, dir), "4"));
+  ASSERT_TRUE(IsValue(cmDefinitions::Get("V5", sub, dir), "5"));
+  ASSERT_TRUE(!cmDefinitions::Get("N", sub, dir));
+  ASSERT_TRUE(IsValue(cmDefinitions::Get("F", sub, dir), "fun"));
+  ASSERT_TRUE(IsValue(cmDefinitions::Get("V6", dir, root), "6"));
+  ASSERT_TRUE(IsValue(cmDefinitions::Get("V7", dir, root), "7"));
+  ASSERT_TRUE(IsValue(cmDefinitions::Get("V4", dir, root), "changed"));
+  ASSERT_TRUE(!cmDefinitions::Get("V5", dir, root));
+
+  for (int i = 8; i < 5000; ++i) {
+    ASSERT_TRUE(IsValue(cmDefinitions::Get(cmStrCat("V", i), sub, dir),
+                        std::to_string(i)));
+  }
+  // 5000 + F - V1 - V3 - V7
+  ASSERT_TRUE(cmDefinitions::ClosureKeys(sub, dir).size() == 4998);
+  return true;
+}
+
+bool testErase()
+{
+  std::cout << "testErase()" << std::endl;
+
+  Tree tree;
+  Tree::iterator root = tree.Root();
+  Tree::iterator dir = tree.Push(root);
+  for (int i = 0; i < 1000; ++i) {
+    dir->Set(cmStrCat("V", i), "value");
+  }
+  for (int i = 0; i < 1000; i += 2) {
+    dir->Unset(cmStrCat("V", i));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(bool(cmDefinitions::Get(cmStrCat("V", i), dir, root)) ==
+                (i % 2 == 1));
+  }
+  ASSERT_TRUE(cmDefinitions::ClosureKeys(dir, root).size() == 500);
+  dir->Set("V0", "again");
+  ASSERT_TRUE(IsValue(cmDefinitions::Get("V0", dir, root), "again"));
+  return true;
+}
+}
+
+int testDefinitions(int /*unused*/, char* /*unused*/ [])
+{
+  int retval = 0;
+
+  if (!testScopes()) {
+    retval = 1;
+  }
+  if (!testClosure()) {
+    retval = 1;
+  }
+  if (!testErase()) {
+    retval = 1;
+  }
+
+  return retval;
+}
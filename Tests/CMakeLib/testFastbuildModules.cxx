@@ -0,0 +1,139 @@
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cm3p/json/value.h>
+
+#include "cmFastbuildModules.h"
+#include "cmScanDepFormat.h"
+#include "cmStringAlgorithms.h"
+
+namespace {
+
+cmFastbuildModules::Source MakeSource(
+  std::string const& node, std::vector<std::string> const& provides,
+  std::vector<std::string> const& requires_)
+{
+  cmFastbuildModules::Source source;
+  source.Node = node;
+  source.Object = cmStrCat("CMakeFiles/app.dir/", node, ".o");
+  for (std::string const& name : provides) {
+    cmSourceReqInfo info;
+    info.LogicalName = name;
+    source.Info.Provides.push_back(info);
+  }
+  for (std::string const& name : requires_) {
+    cmSourceReqInfo info;
+    info.LogicalName = name;
+    source.Info.Requires.push_back(info);
+  }
+  return source;
+}
+
+bool testCollate()
+{
+  std::cout << "testCollate()" << std::endl;
+
+  // "main" uses "a" from this target and "lib" from a linked one, "a"
+  // uses "b" and the intrinsic "iso_c_binding" nobody provides.
+  Json::Value linked(Json::objectValue);
+  linked["lib"]["file"] = "/build/lib.mod";
+  linked["lib"]["node"] = "Fortran_ObjectGroup_lib-1";
+
+  cmFastbuildModules modules;
+  modules.AddLinkedModules(linked);
+  modules.AddSource(MakeSource("main", {}, { "a", "lib" }), "/build/mod",
+                    "/build");
+  modules.AddSource(MakeSource("a", { "a" }, { "b", "iso_c_binding" }),
+                    "/build/mod", "/build");
+  modules.AddSource(MakeSource("b", { "b" }, {}), "/build/mod", "/build");
+
+  std::string error;
+  std::vector<std::string> const order{ "b", "a", "main" };
+  std::set<std::string> const mainDependencies{ "Fortran_ObjectGroup_lib-1",
+                                                "a" };
+  if (!modules.Collate(error) || modules.GetOrder() != order ||
+      modules.GetDependencies("main") != mainDependencies ||
+      modules.GetDependencies("a") != std::set<std::string>{ "b" } ||
+      !modules.GetDependencies("b").empty()) {
+    std::cout << "Unexpected order: " << cmJoin(modules.GetOrder(), ", ")
+              << error << std::endl;
+    return false;
+  }
+
+  Json::Value const provided = modules.WriteModules();
+  if (provided.size() != 2 ||
+      provided["a"]["file"].asString() != "/build/mod/a" ||
+      provided["b"]["node"].asString() != "b") {
+    std::cout << "Unexpected modules:\n"
+              << provided.toStyledString() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool testCycle()
+{
+  std::cout << "testCycle()" << std::endl;
+
+  cmFastbuildModules modules;
+  modules.AddSource(MakeSource("a", { "a" }, { "b" }), "/build", "/build");
+  modules.AddSource(MakeSource("b", { "b" }, { "a" }), "/build", "/build");
+
+  std::string error;
+  if (modules.Collate(error) || error.find("  a\n  b") == std::string::npos) {
+    std::cout << "Cycle not reported: " << error << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool testFragment()
+{
+  std::cout << "testFragment()" << std::endl;
+
+  std::ostringstream os;
+  cmFastbuildModules::WriteFragment(
+    os, "// Object lists",
+    { "CXX_ObjectGroup_app-2", "CXX_ObjectGroup_app-1" },
+    { { "CXX_ObjectGroup_app-1", { "CXX_ObjectGroup_app-2" } } });
+
+  std::string const expected = "// Object lists\n"
+                               "  ObjectList('CXX_ObjectGroup_app-2')\n"
+                               "  {\n"
+                               "    Using(.CXX_ObjectGroup_app_2)\n"
+                               "  }\n"
+                               "  ObjectList('CXX_ObjectGroup_app-1')\n"
+                               "  {\n"
+                               "    Using(.CXX_ObjectGroup_app_1)\n"
+                               "    .PreBuildDependencies + \n"
+                               "    {\n"
+                               "      'CXX_ObjectGroup_app-2'\n"
+                               "    }\n"
+                               "  }\n";
+  if (os.str() != expected) {
+    std::cout << "Unexpected fragment:\n" << os.str() << std::endl;
+    return false;
+  }
+  return true;
+}
+}
+
+int testFastbuildModules(int /*unused*/, char* /*unused*/ [])
+{
+  int retval = 0;
+
+  if (!testCollate()) {
+    retval = 1;
+  }
+  if (!testCycle()) {
+    retval = 1;
+  }
+  if (!testFragment()) {
+    retval = 1;
+  }
+
+  return retval;
+}
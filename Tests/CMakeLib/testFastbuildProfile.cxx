@@ -0,0 +1,150 @@
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cm3p/json/reader.h>
+#include <cm3p/json/value.h>
+
+#include "cmFastbuildProfile.h"
+#include "cmStringAlgorithms.h"
+
+namespace {
+
+// Two libraries in /build, "app" links both. Times are in microseconds.
+const char* NodeMap = R"({
+  "version": 1,
+  "buildDirectory": "/build",
+  "targets": {
+    "core": { "name": "core", "backtrace": "/src/CMakeLists.txt:3",
+              "dependencies": [] },
+    "util": { "name": "util", "dependencies": [] },
+    "app": { "name": "app", "dependencies": [ "core", "util" ] },
+    "all": { "name": "all", "dependencies": [ "app" ] }
+  },
+  "nodes": [
+    { "name": "CXX_ObjectGroup_core-1", "type": "ObjectList",
+      "target": "core", "language": "CXX",
+      "outputDirectory": "CMakeFiles/core.dir" },
+    { "name": "core", "type": "Linker", "target": "core",
+      "outputs": [ "libcore.a" ] },
+    { "name": "CXX_ObjectGroup_util-1", "type": "ObjectList",
+      "target": "util", "language": "CXX",
+      "outputDirectory": "CMakeFiles/util.dir" },
+    { "name": "gen-1234567", "type": "Exec", "target": "app",
+      "outputs": [ "gen/app.cpp" ] },
+    { "name": "app", "type": "Linker", "target": "app",
+      "outputs": [ "app" ] }
+  ]
+})";
+
+bool Parse(const char* text, Json::Value& value)
+{
+  std::istringstream in(text);
+  Json::CharReaderBuilder builder;
+  return Json::parseFromStream(builder, in, &value, nullptr);
+}
+
+bool Load(cmFastbuildProfile& profile, const char* trace)
+{
+  Json::Value nodeMap;
+  Json::Value events;
+  std::string error;
+  if (!Parse(NodeMap, nodeMap) || !Parse(trace, events) ||
+      !profile.LoadNodeMap(nodeMap, error) ||
+      !profile.LoadProfile(events, error)) {
+    std::cout << "Failed to load: " << error << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool Near(double value, double expected)
+{
+  return std::fabs(value - expected) < 1e-9;
+}
+
+bool testAttribution()
+{
+  std::cout << "testAttribution()" << std::endl;
+
+  // Objects are matched by directory, links and custom commands by output,
+  // relative and Windows style paths alike.
+  cmFastbuildProfile profile;
+  if (!Load(profile, R"({ "traceEvents": [
+    { "name": "/build/CMakeFiles/core.dir/a.cpp.o", "ph": "X",
+      "ts": 0, "dur": 1000000, "pid": 1, "tid": 1 },
+    { "name": "/build/CMakeFiles/core.dir/sub/b.cpp.o", "ph": "X",
+      "ts": 0, "dur": 2000000, "pid": 1, "tid": 2 },
+    { "name": "\\build\\libcore.a", "ph": "X",
+      "ts": 2000000, "dur": 500000, "pid": 1, "tid": 1 },
+    { "name": "gen/app.cpp", "ph": "X",
+      "ts": 0, "dur": 250000, "pid": 1, "tid": 3 },
+    { "name": "Parse", "ph": "X", "ts": 0, "dur": 100, "pid": 1, "tid": 0 },
+    { "name": "thread_name", "ph": "M", "pid": 1, "tid": 1 }
+  ] })")) {
+    return false;
+  }
+
+  auto summary = profile.Summarize();
+  if (summary.size() != 2 || summary[0].Name != "core" ||
+      summary[0].Jobs != 3 || !Near(summary[0].Cpu, 3.5) ||
+      !Near(summary[0].Wall, 2.5) ||
+      summary[0].Backtrace != "/src/CMakeLists.txt:3" ||
+      summary[1].Name != "app" || summary[1].Jobs != 1 ||
+      !Near(summary[1].Cpu, 0.25)) {
+    std::cout << "Unexpected summary:\n";
+    profile.WriteReport(std::cout);
+    return false;
+  }
+  return true;
+}
+
+bool testCriticalPath()
+{
+  std::cout << "testCriticalPath()" << std::endl;
+
+  // Begin/end pairs on one thread, complete events on another.
+  cmFastbuildProfile profile;
+  if (!Load(profile, R"([
+    { "name": "CMakeFiles/core.dir/a.cpp.o", "ph": "B", "ts": 0,
+      "pid": 1, "tid": 1 },
+    { "ph": "E", "ts": 3000000, "pid": 1, "tid": 1 },
+    { "name": "CMakeFiles/util.dir/b.cpp.o", "ph": "X",
+      "ts": 0, "dur": 1000000, "pid": 1, "tid": 2 },
+    { "name": "app", "ph": "X",
+      "ts": 3000000, "dur": 2000000, "pid": 1, "tid": 1 }
+  ])")) {
+    return false;
+  }
+
+  std::vector<std::string> const expected{ "core", "app" };
+  auto path = profile.GetCriticalPath();
+  auto summary = profile.Summarize();
+  if (path != expected || summary.size() != 3 || summary[0].Name != "core" ||
+      !Near(summary[0].CriticalPath, 3) || summary[1].Name != "app" ||
+      !Near(summary[1].CriticalPath, 5) || summary[2].Name != "util" ||
+      !Near(summary[2].CriticalPath, 1)) {
+    std::cout << "Unexpected critical path: " << cmJoin(path, " -> ")
+              << std::endl;
+    profile.WriteReport(std::cout);
+    return false;
+  }
+  return true;
+}
+}
+
+int testFastbuildProfile(int /*unused*/, char* /*unused*/ [])
+{
+  int retval = 0;
+
+  if (!testAttribution()) {
+    retval = 1;
+  }
+  if (!testCriticalPath()) {
+    retval = 1;
+  }
+
+  return retval;
+}
@@ -0,0 +1,190 @@
+// Tests cmGlobalFastbuildGenerator::SortByDependencies.
+//
+// Run with "--benchmark [<size>...]" to time it on synthetic target graphs
+// of the given sizes (or a few default ones).
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cmGlobalFastbuildGenerator.h"
+#include "cmStringAlgorithms.h"
+
+namespace {
+
+using Dependencies = std::unordered_multimap<std::string, std::string>;
+
+bool IsOrdered(std::vector<std::string> const& order,
+               Dependencies const& dependencies)
+{
+  std::unordered_map<std::string, size_t> position;
+  for (size_t i = 0; i < order.size(); ++i) {
+    position[order[i]] = i;
+  }
+  for (auto const& [node, dependency] : dependencies) {
+    auto dt = position.find(dependency);
+    if (dt != position.end() && dt->second > position.at(node)) {
+      std::cout << node << " is sorted before its dependency " << dependency
+                << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool testIndependentKeepOrder()
+{
+  std::cout << "testIndependentKeepOrder()" << std::endl;
+
+  std::vector<std::string> nodes{ "c", "a", "d", "b" };
+  Dependencies dependencies{ { "c", "b" }, { "x", "a" }, { "d", "unknown" } };
+
+  auto cycle =
+    cmGlobalFastbuildGenerator::SortByDependencies(nodes, dependencies);
+
+  std::vector<std::string> const expected{ "a", "d", "b", "c" };
+  if (!cycle.empty() || nodes != expected) {
+    std::cout << "Unexpected order: " << cmJoin(nodes, ", ") << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool testCycle()
+{
+  std::cout << "testCycle()" << std::endl;
+
+  std::vector<std::string> nodes{ "a", "b", "c", "d" };
+  Dependencies dependencies{ { "b", "c" }, { "c", "b" }, { "d", "b" } };
+
+  auto cycle =
+    cmGlobalFastbuildGenerator::SortByDependencies(nodes, dependencies);
+
+  // d only depends on the cycle, it is not part of it.
+  std::vector<std::string> const expected{ "a", "b", "c", "d" };
+  std::vector<std::string> const expectedCycle{ "b", "c" };
+  if (nodes != expected || cycle != expectedCycle) {
+    std::cout << "Unexpected order: " << cmJoin(nodes, ", ")
+              << "\nUnexpected cycle: " << cmJoin(cycle, ", ") << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool testSeveralCycles()
+{
+  std::cout << "testSeveralCycles()" << std::endl;
+
+  // d is between the cycles b-c and e-f, g depends on itself.
+  std::vector<std::string> nodes{ "a", "b", "c", "d", "e", "f", "g", "h" };
+  Dependencies dependencies{ { "b", "c" }, { "c", "b" }, { "d", "c" },
+                             { "e", "d" }, { "e", "f" }, { "f", "e" },
+                             { "g", "g" }, { "h", "a" } };
+
+  auto cycle =
+    cmGlobalFastbuildGenerator::SortByDependencies(nodes, dependencies);
+
+  std::vector<std::string> const expected{ "a", "h", "b", "c",
+                                           "d", "e", "f", "g" };
+  std::vector<std::string> const expectedCycle{ "b", "c", "e", "f", "g" };
+  if (nodes != expected || cycle != expectedCycle) {
+    std::cout << "Unexpected order: " << cmJoin(nodes, ", ")
+              << "\nUnexpected cycle: " << cmJoin(cycle, ", ") << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Synthetic target graph: every node depends on the previous one and on a
+// few pseudo-random earlier nodes. Nodes are listed in reverse so the
+// whole graph needs reordering.
+void MakeLargeGraph(size_t size, std::vector<std::string>& nodes,
+                    Dependencies& dependencies)
+{
+  unsigned int seed = 1;
+  for (size_t i = 0; i < size; ++i) {
+    std::string name = "target" + std::to_string(i);
+    if (i > 0) {
+      dependencies.emplace(name, "target" + std::to_string(i - 1));
+      for (int j = 0; j < 4; ++j) {
+        seed = seed * 1103515245 + 12345;
+        dependencies.emplace(name, "target" + std::to_string(seed % i));
+      }
+    }
+    nodes.push_back(std::move(name));
+  }
+  std::reverse(nodes.begin(), nodes.end());
+}
+
+bool testLargeGraph(size_t size)
+{
+  std::cout << "testLargeGraph(" << size << ")" << std::endl;
+
+  std::vector<std::string> nodes;
+  Dependencies dependencies;
+  MakeLargeGraph(size, nodes, dependencies);
+
+  auto cycle =
+    cmGlobalFastbuildGenerator::SortByDependencies(nodes, dependencies);
+
+  return cycle.empty() && nodes.size() == size &&
+    IsOrdered(nodes, dependencies);
+}
+
+int runBenchmark(int argc, char* argv[])
+{
+  std::vector<size_t> sizes;
+  for (int i = 0; i < argc; ++i) {
+    sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+  }
+  if (sizes.empty()) {
+    sizes = { 1000, 10000, 100000 };
+  }
+
+  for (size_t size : sizes) {
+    std::vector<std::string> nodes;
+    Dependencies dependencies;
+    MakeLargeGraph(size, nodes, dependencies);
+
+    auto const start = std::chrono::steady_clock::now();
+    cmGlobalFastbuildGenerator::SortByDependencies(nodes, dependencies);
+    std::chrono::duration<double, std::milli> const elapsed =
+      std::chrono::steady_clock::now() - start;
+    std::cout << size << " targets, " << dependencies.size()
+              << " dependencies: " << elapsed.count() << " ms\n";
+  }
+  return 0;
+}
+}
+
+int testFastbuildSortByDependencies(int argc, char* argv[])
+{
+  if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+    return runBenchmark(argc - 2, argv + 2);
+  }
+
+  int retval = 0;
+
+  if (!testIndependentKeepOrder()) {
+    retval = 1;
+  }
+  if (!testCycle()) {
+    retval = 1;
+  }
+  if (!testSeveralCycles()) {
+    retval = 1;
+  }
+  for (size_t size : { 1000, 10000, 50000 }) {
+    if (!testLargeGraph(size)) {
+      retval = 1;
+    }
+  }
+
+  return retval;
+}
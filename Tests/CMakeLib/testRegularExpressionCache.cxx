@@ -0,0 +1,88 @@
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include "cmsys/RegularExpression.hxx"
+
+#include "cmRegularExpressionCache.h"
+#include "cmStringAlgorithms.h"
+
+namespace {
+
+#define ASSERT_TRUE(x)                                                        \
+  do {                                                                        \
+    if (!(x)) {                                                               \
+      std::cout << "ASSERT_TRUE(" #x ") failed on line " << __LINE__ << "\n"; \
+      return false;                                                           \
+    }                                                                         \
+  } while (false)
+
+bool testShared()
+{
+  std::cout << "testShared()" << std::endl;
+
+  auto const before = cmRegularExpressionCache::GetStatistics();
+  auto first = cmRegularExpressionCache::Get("^([a-z]+)-([0-9]+)$");
+  auto second = cmRegularExpressionCache::Get("^([a-z]+)-([0-9]+)$");
+  ASSERT_TRUE(first && first == second);
+  auto const after = cmRegularExpressionCache::GetStatistics();
+  ASSERT_TRUE(after.Misses == before.Misses + 1);
+  ASSERT_TRUE(after.Hits == before.Hits + 1);
+
+  // Every user keeps its own match.
+  cmsys::RegularExpressionMatch a;
+  cmsys::RegularExpressionMatch b;
+  ASSERT_TRUE(first->find("abc-12", a));
+  ASSERT_TRUE(second->find("xy-3", b));
+  ASSERT_TRUE(a.match(1) == "abc" && a.match(2) == "12");
+  ASSERT_TRUE(b.match(1) == "xy" && b.match(2) == "3");
+  return true;
+}
+
+bool testInvalid()
+{
+  std::cout << "testInvalid()" << std::endl;
+
+  ASSERT_TRUE(!cmRegularExpressionCache::Get("(unbalanced"));
+  ASSERT_TRUE(!cmRegularExpressionCache::Get("(unbalanced"));
+  return true;
+}
+
+bool testEviction()
+{
+  std::cout << "testEviction()" << std::endl;
+
+  auto oldest = cmRegularExpressionCache::Get("^oldest$");
+  auto recent = cmRegularExpressionCache::Get("^recent$");
+  for (std::size_t i = 1; i < cmRegularExpressionCache::Capacity; ++i) {
+    cmRegularExpressionCache::Get(cmStrCat("^pattern", i, '$'));
+    if (i % 100 == 0) {
+      cmRegularExpressionCache::Get("^recent$");
+    }
+  }
+
+  // Users keep evicted expressions alive.
+  cmsys::RegularExpressionMatch match;
+  ASSERT_TRUE(oldest->find("oldest", match));
+  ASSERT_TRUE(cmRegularExpressionCache::Get("^recent$") == recent);
+  ASSERT_TRUE(cmRegularExpressionCache::Get("^oldest$") != oldest);
+  return true;
+}
+}
+
+int testRegularExpressionCache(int /*unused*/, char* /*unused*/ [])
+{
+  int retval = 0;
+
+  if (!testShared()) {
+    retval = 1;
+  }
+  if (!testInvalid()) {
+    retval = 1;
+  }
+  if (!testEviction()) {
+    retval = 1;
+  }
+
+  return retval;
+}
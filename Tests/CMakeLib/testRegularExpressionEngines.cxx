@@ -0,0 +1,401 @@
+/* Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+   file Copyright.txt or https://cmake.org/licensing for details.  */
+
+// Compares the backtracking cmsys::RegularExpression with
+// cmRegularExpressionAutomaton.
+//
+// Run with "--benchmark [<build-log>...]" to time both engines on patterns
+// from the CMake modules, on the default CTest build-log expressions over
+// the given build logs (or a generated one), and on a pathological pattern.
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "cmsys/FStream.hxx"
+#include "cmsys/RegularExpression.hxx"
+
+#include "cmRegularExpressionAutomaton.h"
+#include "cmStringAlgorithms.h"
+
+namespace {
+
+// Patterns used by the modules shipped with CMake.
+char const* const modulePatterns[] = {
+  "^[0-9]+$",
+  "[0-9]+(\\.[0-9]+)*",
+  "^INFO:([0-9]+\\.[0-9]+\\.[0-9]+)(-patch([0-9]+))?",
+  "(.+)=([0-9]+\\.?[0-9]*)",
+  " (-I ?)([^ ]*)",
+  "(^| )(-Wl,|-Xlinker +)([^\" ]+)",
+  "-target-cpu sm_([0-9]+)",
+  "/([^/]+)\\.framework$",
+  "(.+-)?llvm-$",
+  "^Intel10_64i?lp_seq$",
+  "GNU|Clang|QCC",
+  "[^/]+\\.framework/",
+  "ans[\r\n\t ]*=[\r\n\t ]*'?([0-9]+(\\.[0-9]+)?)",
+  "-L[^;]+",
+  "<file[^<]+",
+};
+
+// Subjects the module patterns are matched against.
+char const* const moduleSubjects[] = {
+  "",
+  "12345",
+  "11.4.0",
+  "INFO:3.24.2-patch7",
+  "GNU 12.2.0 x86_64-linux-gnu",
+  "CMAKE_SIZEOF_VOID_P=8",
+  "/usr/bin/c++ -I /usr/include -I/opt/include -O2 -c foo.cxx",
+  "gcc -Wl,--as-needed -Xlinker  -rpath -Wl,/usr/lib foo.o -lm",
+  "ptxas -target-cpu sm_75 -target-cpu sm_86",
+  "/System/Library/Frameworks/Cocoa.framework",
+  "/Library/Frameworks/Python.framework/Versions/3.9",
+  "x86_64-linux-gnu-llvm-",
+  "Intel10_64ilp_seq",
+  "Clang",
+  "ans =\n\n   9.14",
+  "-L/usr/lib;-L/usr/local/lib;-lfoo",
+  "<file name=\"a\"/><file name=\"b\"/>",
+  "abc\ndef\n",
+};
+
+// The default error and warning expressions of the CTest build-log scanner.
+char const* const logPatterns[] = {
+  "^[Bb]us [Ee]rror",
+  "^[Ss]egmentation [Vv]iolation",
+  "^[Ss]egmentation [Ff]ault",
+  ":.*[Pp]ermission [Dd]enied",
+  "([^ :]+):([0-9]+): ([^ \\t])",
+  "([^:]+): error[ \\t]*[0-9]+[ \\t]*:",
+  "^Error ([0-9]+):",
+  "^Fatal",
+  "^Error: ",
+  "^Error ",
+  "[0-9] ERROR: ",
+  "^\"[^\"]+\", line [0-9]+: [^Ww]",
+  "([^ :]+) : (error|fatal error|catastrophic error)",
+  "([^:]+): (Error:|error|undefined reference|multiply defined)",
+  "([^:]+)\\(([^\\)]+)\\) ?: (error|fatal error|catastrophic error)",
+  "^collect2: ld returned 1 exit status",
+  "make: \\*\\*\\*.*Error",
+  ": No such file or directory",
+  "([^ :]+):([0-9]+): warning:",
+  "([^ :]+):([0-9]+): note:",
+  "([^:]+): warning ([0-9]+):",
+  "^(Warning|Warnung) ([0-9]+):",
+  "([^:]+): warning",
+  ".*file: .* has no symbols",
+  "\\([0-9]*\\): remark #[0-9]*",
+  "^CMake Warning.*:",
+};
+
+// Lines found in build logs.
+char const* const logSubjects[] = {
+  "[ 42%] Building CXX object Source/CMakeFiles/CMakeLib.dir/cmMakefile.cxx.o",
+  "/usr/bin/c++ -DCURL_STATICLIB -I/src/Utilities -O2 -g -std=c++17 -o "
+  "CMakeFiles/CMakeLib.dir/cmMakefile.cxx.o -c /src/Source/cmMakefile.cxx",
+  "/src/Source/cmMakefile.cxx:1234:5: warning: unused variable 'x' "
+  "[-Wunused-variable]",
+  "/src/Source/cmMakefile.cxx:99:1: error: expected ';' before '}' token",
+  "foo.cxx(12): error C2065: 'bar': undeclared identifier",
+  "main.o: In function `main': undefined reference to `foo'",
+  "collect2: ld returned 1 exit status",
+  "make[2]: *** [Makefile:100: all] Error 2",
+  "CMake Warning (dev) at CMakeLists.txt:3 (project):",
+  "ranlib: file: libfoo.a(bar.o) has no symbols",
+  "",
+};
+
+bool sameMatch(cmsys::RegularExpressionMatch const& a,
+               cmRegularExpressionAutomaton const& b)
+{
+  for (int i = 0; i < cmsys::RegularExpressionMatch::NSUBEXP; ++i) {
+    if (a.match(i) != b.GetMatch(i)) {
+      return false;
+    }
+    if (!a.match(i).empty() &&
+        (a.start(i) != b.GetStart(i) || a.end(i) != b.GetEnd(i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool compare(char const* pattern, char const* subject)
+{
+  cmsys::RegularExpression backtracking(pattern);
+  cmRegularExpressionAutomaton automaton(pattern);
+  if (backtracking.is_valid() != automaton.IsValid()) {
+    std::cout << "Validity differs for \"" << pattern << "\"\n";
+    return false;
+  }
+  if (!backtracking.is_valid()) {
+    return true;
+  }
+
+  cmsys::RegularExpressionMatch expected;
+  bool const found = backtracking.find(subject, expected);
+  if (automaton.Find(subject) != found ||
+      (found && !sameMatch(expected, automaton))) {
+    std::cout << "Engines differ for \"" << pattern << "\" on \"" << subject
+              << "\":\n";
+    for (int i = 0; i < cmsys::RegularExpressionMatch::NSUBEXP; ++i) {
+      std::cout << "  " << i << ": \"" << expected.match(i) << "\" \""
+                << automaton.GetMatch(i) << "\"\n";
+    }
+    return false;
+  }
+  return true;
+}
+
+bool testSameMatches()
+{
+  std::cout << "testSameMatches()" << std::endl;
+
+  // Constructs whose submatches depend on the order alternatives are tried.
+  static char const* const patterns[] = {
+    "a|ab",
+    "(a|ab)(c|bcd)(d*)",
+    "(a+)(a*)",
+    "(a*)(a+)",
+    "((a)|(b))*",
+    "((a)|(b))+c",
+    "(ab|a)(bc|c)?",
+    "x*y?z*",
+    "^$",
+    "$",
+    "^",
+    "(.*)=(.*)",
+    "(.*)(\\.[^.]*)$",
+    "([^/]*)/([^/]*)/(.*)",
+    "[a-c]+[^a-c]+",
+    "(a(b(c(d(e(f(g(h(i)))))))))",
+    "(foo|foobar)(bar)?$",
+    "b*c*d*e*$",
+    "(b|bc|bcd)+d",
+    "a.*b.*c",
+    "^a|b$",
+    "[]]+",
+    "[-a]+",
+  };
+  static char const* const subjects[] = {
+    "",
+    "a",
+    "ab",
+    "abcd",
+    "aaa",
+    "aaab",
+    "abbac",
+    "abc",
+    "foobar",
+    "foobarbar",
+    "x=1=2",
+    "file.tar.gz",
+    "a/b/c/d",
+    "abcdefghi",
+    "xxbcbcdd",
+    "]]a",
+    "-a-b",
+    "a\nb",
+  };
+
+  bool result = true;
+  for (char const* pattern : patterns) {
+    for (char const* subject : subjects) {
+      result = compare(pattern, subject) && result;
+    }
+  }
+  for (char const* pattern : modulePatterns) {
+    for (char const* subject : moduleSubjects) {
+      result = compare(pattern, subject) && result;
+    }
+  }
+  for (char const* pattern : logPatterns) {
+    for (char const* subject : logSubjects) {
+      result = compare(pattern, subject) && result;
+    }
+  }
+  return result;
+}
+
+bool testLinearTime()
+{
+  std::cout << "testLinearTime()" << std::endl;
+
+  // The backtracking engine tries every way to split the run of "a"
+  // between the alternatives, and does so from every start position.
+  cmRegularExpressionAutomaton re("(a|aa)*c$");
+  std::string const subject(100000, 'a');
+  if (re.Find(subject + "cx")) {
+    std::cout << "\"(a|aa)*c$\" matches a string not ending in c\n";
+    return false;
+  }
+  if (!re.Find(subject + 'c') || re.GetStart() != 0 ||
+      re.GetEnd() != subject.size() + 1) {
+    std::cout << "\"(a|aa)*c$\" does not match the whole string\n";
+    return false;
+  }
+  return true;
+}
+
+bool testInvalid()
+{
+  std::cout << "testInvalid()" << std::endl;
+
+  static char const* const patterns[] = {
+    "(",       "a)",         "a**",        "*a",      "a|*",
+    "[a",      "[^]",        "[z-a]",      "a\\",     "(a*)*",
+    "(a|)+",   "(a?)*",      "()+",        "^*",      "$+",
+    "((((((((((a))))))))))", "(((((((((a)))))))))",
+  };
+
+  bool result = true;
+  for (char const* pattern : patterns) {
+    result = compare(pattern, "aaa") && result;
+  }
+
+  cmRegularExpressionAutomaton re;
+  if (re.Compile("(a") || re.IsValid() || re.Find("a") ||
+      re.GetError() != "Unmatched parentheses.") {
+    std::cout << "\"(a\" compiled: " << re.GetError() << "\n";
+    return false;
+  }
+  return result;
+}
+
+bool testCopy()
+{
+  std::cout << "testCopy()" << std::endl;
+
+  cmRegularExpressionAutomaton re("(b+)c");
+  cmRegularExpressionAutomaton copy(re);
+  cmRegularExpressionAutomaton assigned;
+  assigned = re;
+  if (!copy.Find("bc") || !assigned.Find("abbbc") ||
+      assigned.GetMatch(1) != "bbb" || copy.GetMatch(1) != "b") {
+    std::cout << "Copy does not match\n";
+    return false;
+  }
+  return true;
+}
+
+template <typename Find>
+double nanosecondsPerFind(Find find, std::vector<std::string> const& subjects,
+                          std::size_t repeat)
+{
+  std::size_t finds = 0;
+  auto const start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < repeat; ++i) {
+    for (std::string const& subject : subjects) {
+      find(subject);
+      ++finds;
+    }
+  }
+  std::chrono::duration<double, std::nano> const elapsed =
+    std::chrono::steady_clock::now() - start;
+  return finds == 0 ? 0 : elapsed.count() / static_cast<double>(finds);
+}
+
+void benchmark(std::string const& name,
+               std::vector<std::string> const& patterns,
+               std::vector<std::string> const& subjects, std::size_t repeat)
+{
+  double backtrackingTotal = 0;
+  double automatonTotal = 0;
+  std::cout << name << " (" << subjects.size() << " subjects, ns per find)\n";
+  for (std::string const& pattern : patterns) {
+    cmsys::RegularExpression const backtracking(pattern);
+    cmRegularExpressionAutomaton automaton(pattern);
+    cmsys::RegularExpressionMatch match;
+    double const b = nanosecondsPerFind(
+      [&](std::string const& subject) {
+        backtracking.find(subject.c_str(), match);
+      },
+      subjects, repeat);
+    double const a = nanosecondsPerFind(
+      [&](std::string const& subject) { automaton.Find(subject); }, subjects,
+      repeat);
+    backtrackingTotal += b;
+    automatonTotal += a;
+    std::cout << std::setw(12) << static_cast<long>(b) << std::setw(12)
+              << static_cast<long>(a) << "  " << pattern << '\n';
+  }
+  std::cout << std::setw(12) << static_cast<long>(backtrackingTotal)
+            << std::setw(12) << static_cast<long>(automatonTotal)
+            << "  total (backtracking, automaton)\n\n";
+}
+
+int runBenchmark(int argc, char* argv[])
+{
+  std::vector<std::string> patterns(std::begin(modulePatterns),
+                                    std::end(modulePatterns));
+  std::vector<std::string> subjects(std::begin(moduleSubjects),
+                                    std::end(moduleSubjects));
+  benchmark("Module patterns", patterns, subjects, 2000);
+
+  std::vector<std::string> lines;
+  for (int i = 0; i < argc; ++i) {
+    cmsys::ifstream fin(argv[i]);
+    if (!fin) {
+      std::cerr << "Cannot read " << argv[i] << '\n';
+      return 1;
+    }
+    std::string line;
+    while (std::getline(fin, line)) {
+      lines.push_back(line);
+    }
+  }
+  if (lines.empty()) {
+    // A build log of long compiler command lines with some diagnostics.
+    std::string const flags(600, 'x');
+    for (int i = 0; i < 5000; ++i) {
+      lines.push_back(cmStrCat("/usr/bin/c++ -I/src/include/", flags,
+                               " -o CMakeFiles/lib.dir/file", i,
+                               ".cxx.o -c /src/file", i, ".cxx"));
+      lines.emplace_back(logSubjects[i % (sizeof(logSubjects) /
+                                          sizeof(logSubjects[0]))]);
+    }
+  }
+  patterns.assign(std::begin(logPatterns), std::end(logPatterns));
+  benchmark("Build log", patterns, lines, 1);
+
+  std::vector<std::string> pathological;
+  for (std::size_t n = 16; n <= 24; n += 4) {
+    pathological.push_back(std::string(n, 'a') + "cx");
+  }
+  patterns.assign(1, "(a|aa)*c$");
+  benchmark("Pathological", patterns, pathological, 1);
+  return 0;
+}
+}
+
+int testRegularExpressionEngines(int argc, char* argv[])
+{
+  if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+    return runBenchmark(argc - 2, argv + 2);
+  }
+
+  int retval = 0;
+
+  if (!testSameMatches()) {
+    retval = 1;
+  }
+  if (!testLinearTime()) {
+    retval = 1;
+  }
+  if (!testInvalid()) {
+    retval = 1;
+  }
+  if (!testCopy()) {
+    retval = 1;
+  }
+
+  return retval;
+}
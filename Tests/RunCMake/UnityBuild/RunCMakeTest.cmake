@@ -16,6 +16,12 @@ run_cmake(unitybuild_cxx)
 run_cmake(unitybuild_cxx_group)
 run_cmake(unitybuild_c_and_cxx)
 run_cmake(unitybuild_c_and_cxx_group)
+if(CMake_TEST_OBJC)
+  run_cmake(unitybuild_objc)
+endif()
+if(CMake_TEST_CUDA)
+  run_cmake(unitybuild_cuda)
+endif()
 run_cmake(unitybuild_batchsize)
 run_cmake(unitybuild_default_batchsize)
 run_cmake(unitybuild_skip)
@@ -0,0 +1,13 @@
+set(unitybuild_cuda "${RunCMake_TEST_BINARY_DIR}/CMakeFiles/tgt.dir/Unity/unity_0_cu.cu")
+if(NOT EXISTS "${unitybuild_cuda}")
+  set(RunCMake_TEST_FAILED "Generated unity source files ${unitybuild_cuda} does not exist.")
+  return()
+endif()
+
+if(RunCMake_GENERATOR MATCHES "Fastbuild")
+  file(READ "${RunCMake_TEST_BINARY_DIR}/CMakeFiles/fbuild/tgt.bff" bff)
+  if(NOT bff MATCHES "\\.UnityOutputPattern = 'fbuild_unity_[0-9]+_\\*_cu\\.cu'")
+    set(RunCMake_TEST_FAILED "Fastbuild Unity node does not produce .cu sources.")
+    return()
+  endif()
+endif()
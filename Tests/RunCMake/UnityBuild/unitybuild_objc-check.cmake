@@ -0,0 +1,13 @@
+set(unitybuild_objc "${RunCMake_TEST_BINARY_DIR}/CMakeFiles/tgt.dir/Unity/unity_0_m.m")
+if(NOT EXISTS "${unitybuild_objc}")
+  set(RunCMake_TEST_FAILED "Generated unity source files ${unitybuild_objc} does not exist.")
+  return()
+endif()
+
+if(RunCMake_GENERATOR MATCHES "Fastbuild")
+  file(READ "${RunCMake_TEST_BINARY_DIR}/CMakeFiles/fbuild/tgt.bff" bff)
+  if(NOT bff MATCHES "\\.UnityOutputPattern = 'fbuild_unity_[0-9]+_\\*_m\\.m'")
+    set(RunCMake_TEST_FAILED "Fastbuild Unity node does not produce .m sources.")
+    return()
+  endif()
+endif()
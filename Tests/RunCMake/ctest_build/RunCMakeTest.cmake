@@ -49,6 +49,15 @@ function(run_BuildChangeId)
 endfunction()
 run_BuildChangeId()
 
+function(run_InvalidErrorMatch)
+  set(CASE_TEST_PREFIX_CODE [[
+    set(CTEST_CUSTOM_ERROR_MATCH "(unmatched")
+  ]])
+
+  run_ctest(InvalidErrorMatch)
+endfunction()
+run_InvalidErrorMatch()
+
 set(RunCMake_USE_CUSTOM_BUILD_COMMAND TRUE)
 set(RunCMake_BUILD_COMMAND "${FAKE_BUILD_COMMAND_EXE}")
 run_ctest(BuildCommandFailure)
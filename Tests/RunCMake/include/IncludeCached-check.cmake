@@ -0,0 +1,26 @@
+if(NOT EXISTS "${ProfilingTestOutput}")
+  set(RunCMake_TEST_FAILED "Expected ${ProfilingTestOutput} to exist")
+  return()
+endif()
+
+# The counter events report the hits and misses so far, keep the last.
+file(READ "${ProfilingTestOutput}" profile)
+string(JSON length LENGTH "${profile}")
+math(EXPR last "${length} - 1")
+set(hits "")
+foreach(i RANGE ${last})
+  string(JSON phase GET "${profile}" ${i} ph)
+  if(phase STREQUAL "C")
+    string(JSON name GET "${profile}" ${i} name)
+    if(name STREQUAL "list file cache")
+      string(JSON hits GET "${profile}" ${i} args hits)
+    endif()
+  endif()
+endforeach()
+
+if(hits STREQUAL "")
+  set(RunCMake_TEST_FAILED "No \"list file cache\" counter event found")
+elseif(hits LESS 2)
+  set(RunCMake_TEST_FAILED
+    "The \"list file cache\" counter has ${hits} hits, expected at least 2")
+endif()
@@ -0,0 +1,9 @@
+# A file of the source tree, unchanged for long, is parsed once and read
+# from the list file cache by the later includes.
+set(count 0)
+foreach(i 1 2 3)
+  include(${CMAKE_CURRENT_SOURCE_DIR}/IncludeCachedFile.cmake)
+endforeach()
+if(NOT count EQUAL 3)
+  message(FATAL_ERROR "Included file ran ${count} times, expected 3.")
+endif()
@@ -0,0 +1 @@
+math(EXPR count "${count} + 1")
@@ -0,0 +1,11 @@
+# A file written during configure is read again after every change, even
+# one that keeps its size within the same second.
+set(file "${CMAKE_CURRENT_BINARY_DIR}/rewritten.cmake")
+foreach(value 1 2 3)
+  file(WRITE "${file}" "set(result ${value})\n")
+  include("${file}")
+  if(NOT result STREQUAL "${value}")
+    message(FATAL_ERROR "Included \"${file}\" set result to \"${result}\", "
+      "expected \"${value}\".")
+  endif()
+endforeach()
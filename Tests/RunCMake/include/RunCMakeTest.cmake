@@ -7,3 +7,9 @@ run_cmake(CMP0024-NEW)
 run_cmake(ExportExportInclude)
 run_cmake(IncludeIsDirectory)
 run_cmake(IncludeMalformed)
+run_cmake(IncludeRewritten)
+
+set(ProfilingTestOutput ${RunCMake_BINARY_DIR}/IncludeCached-build/output.json)
+set(RunCMake_TEST_OPTIONS --profiling-format=google-trace --profiling-output=${ProfilingTestOutput})
+run_cmake(IncludeCached)
+unset(RunCMake_TEST_OPTIONS)
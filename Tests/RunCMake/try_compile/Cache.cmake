@@ -0,0 +1,31 @@
+enable_language(C)
+
+try_compile(result ${CMAKE_CURRENT_BINARY_DIR}
+  SOURCES ${CMAKE_CURRENT_SOURCE_DIR}/cache.c
+  CMAKE_FLAGS -DINCLUDE_DIRECTORIES=${cache_include_dir}
+  OUTPUT_VARIABLE out
+  COPY_FILE ${CMAKE_CURRENT_BINARY_DIR}/copy
+  )
+if(expect_failure)
+  if(result)
+    message(FATAL_ERROR "try_compile succeeded but was expected to fail")
+  endif()
+else()
+  if(NOT result)
+    message(FATAL_ERROR "try_compile failed:\n${out}")
+  endif()
+  if(NOT EXISTS "${CMAKE_CURRENT_BINARY_DIR}/copy")
+    message(FATAL_ERROR "try_compile did not copy the built file")
+  endif()
+endif()
+
+if(out MATCHES "^Restored from the try_compile cache")
+  set(restored 1)
+else()
+  set(restored 0)
+endif()
+if(NOT restored EQUAL expect_restored)
+  message(FATAL_ERROR
+    "try_compile result restored: ${restored}, expected: ${expect_restored}\n"
+    "${out}")
+endif()
@@ -0,0 +1,4 @@
+set(expect_failure 1)
+set(expect_restored 0)
+include(${CMAKE_CURRENT_LIST_DIR}/Cache.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/Cache.cmake)
@@ -0,0 +1,2 @@
+set(expect_restored 0)
+include(${CMAKE_CURRENT_LIST_DIR}/Cache.cmake)
@@ -23,6 +23,23 @@ run_cmake(PlatformVariables)
 run_cmake(WarnDeprecated)
 unset(RunCMake_TEST_OPTIONS)
 
+set(cache_dir "${RunCMake_BINARY_DIR}/TryCompileCache")
+set(cache_include_dir "${RunCMake_BINARY_DIR}/TryCompileCacheInclude")
+file(REMOVE_RECURSE "${cache_dir}")
+file(WRITE "${cache_include_dir}/cache.h" "#define CACHE_RESULT 0\n")
+set(RunCMake_TEST_OPTIONS -DCMAKE_TRY_COMPILE_CACHE_DIR=${cache_dir}
+  -Dcache_include_dir=${cache_include_dir})
+run_cmake(CacheMiss)
+run_cmake(CacheHit)
+# Break the header the cache key does not cover and check that verification
+# notices the stale entry, and that failures are never restored.
+file(WRITE "${cache_include_dir}/cache.h" "#error broken\n")
+list(APPEND RunCMake_TEST_OPTIONS -DCMAKE_TRY_COMPILE_CACHE_VERIFY=100)
+run_cmake(CacheStale)
+list(REMOVE_ITEM RunCMake_TEST_OPTIONS -DCMAKE_TRY_COMPILE_CACHE_VERIFY=100)
+run_cmake(CacheFailure)
+unset(RunCMake_TEST_OPTIONS)
+
 run_cmake(TargetTypeExe)
 run_cmake(TargetTypeInvalid)
 run_cmake(TargetTypeStatic)
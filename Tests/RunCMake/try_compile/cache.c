@@ -0,0 +1,6 @@
+#include "cache.h"
+
+int main(void)
+{
+  return CACHE_RESULT;
+}
@@ -0,0 +1,53 @@
+#!/usr/bin/env bash
+
+# Time the configure step of a synthetic project with a deep and wide
+# directory tree and many variables, the load on the variable scopes every
+# add_subdirectory creates.
+#
+# Usage: benchmark-configure.bash <cmake> [<depth> [<width> [<variables>]]]
+
+set -e
+
+cmake="${1:?usage: ${0##*/} <cmake> [<depth> [<width> [<variables>]]]}"
+depth="${2:-6}"
+width="${3:-4}"
+variables="${4:-2000}"
+
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+
+# Every directory sets a few variables of its own and adds <width>
+# subdirectories until <depth> is reached.
+write_dir() {
+    local dir="$1" level="$2" i
+    mkdir -p "$dir"
+    {
+        echo "set(dir_${level}_var \"\${CMAKE_CURRENT_SOURCE_DIR}\")"
+        echo "set(top_var_1 \"\${top_var_1};${level}\")"
+        if [[ "$level" -lt "$depth" ]]; then
+            for ((i = 0; i < width; ++i)); do
+                echo "add_subdirectory(d$i)"
+            done
+        fi
+    } > "$dir/CMakeLists.txt"
+    if [[ "$level" -lt "$depth" ]]; then
+        for ((i = 0; i < width; ++i)); do
+            write_dir "$dir/d$i" $((level + 1))
+        done
+    fi
+}
+
+# width^(depth - 1) directories below the top one.
+write_dir "$work/src/tree" 1
+{
+    echo "cmake_minimum_required(VERSION 3.21)"
+    echo "project(ConfigureBenchmark NONE)"
+    echo "foreach(i RANGE 1 ${variables})"
+    echo "  set(top_var_\${i} \"value \${i}\")"
+    echo "endforeach()"
+    echo "add_subdirectory(tree)"
+} > "$work/src/CMakeLists.txt"
+
+directories="$(find "$work/src" -name CMakeLists.txt | wc -l)"
+echo "Configuring ${directories} directories with ${variables} variables"
+time "$cmake" -S "$work/src" -B "$work/build" -G "Unix Makefiles" > /dev/null
@@ -0,0 +1,15 @@
+#!/usr/bin/env bash
+
+# Compare the backtracking cmsys::RegularExpression with
+# cmRegularExpressionAutomaton on patterns of the CMake modules, on the
+# default CTest build-log expressions over build logs, and on a pathological
+# pattern.  Without a build log, a generated one is used.
+#
+# Usage: benchmark-regex.bash <CMakeLibTests> [<build-log>...]
+
+set -e
+
+tests="${1:?usage: ${0##*/} <CMakeLibTests> [<build-log>...]}"
+shift
+
+"$tests" testRegularExpressionEngines --benchmark "$@"